@@ -13,28 +13,129 @@
 #ifndef APPLICATION_HPP
 #define APPLICATION_HPP
 
+#include <atomic>
 #include <iostream>
 #include <csignal>
+#include <thread>
+#include <string>
+#ifndef _WIN32
+    #include <cerrno>
+    #include <unistd.h>
+#endif
 #include <dds/core/ddscore.hpp>
 
+#include "console_output.hpp"
+
 
 namespace application {
 
-// Catch control-C and tell application to shut down
-bool running = true;
+// Catch control-C and tell application to shut down. The signal handler
+// sets it, so it must be lock-free.
+static_assert(ATOMIC_BOOL_LOCK_FREE == 2, "running must be lock-free");
+std::atomic<bool> running(true);
+
+// Triggered on control-C. A loop that attaches it to its WaitSet wakes up
+// at once, instead of when its wait() or dispatch() times out.
+inline dds::core::cond::GuardCondition& shutdown_condition()
+{
+    static dds::core::cond::GuardCondition condition;
+    return condition;
+}
+
+inline void request_shutdown()
+{
+    std::cout << "preparing to shut down..." << std::endl;
+    shutdown_condition().trigger_value(true);
+}
+
+#ifndef _WIN32
+// A signal handler may only call async-signal-safe functions, which
+// trigger_value() is not. It writes to this pipe instead, and a thread
+// blocked reading it calls request_shutdown().
+int shutdown_pipe[2] = { -1, -1 };
+std::thread shutdown_thread;
+#endif
 
 inline void stop_handler(int)
 {
     running = false;
-    std::cout << "preparing to shut down..." << std::endl;
+#ifdef _WIN32
+    // Windows runs the handler in a thread of its own
+    request_shutdown();
+#else
+    char signal_byte = 0;
+    ssize_t written = write(shutdown_pipe[1], &signal_byte, 1);
+    (void) written;  // Without the pipe, loops stop at their next timeout
+#endif
 }
 
 inline void setup_signal_handlers()
 {
+    shutdown_condition();  // Created here, not in the signal path
+#ifndef _WIN32
+    if (pipe(shutdown_pipe) == 0) {
+        shutdown_thread = std::thread([]() {
+            char signal_byte;
+            ssize_t result;
+            while ((result = read(shutdown_pipe[0], &signal_byte, 1)) != 0) {
+                if (result == 1) {
+                    request_shutdown();
+                } else if (errno != EINTR) {
+                    break;
+                }
+            }
+        });
+    }
+#endif
     signal(SIGINT, stop_handler);
     signal(SIGTERM, stop_handler);
 }
 
+// After this, control-C only stops the loops that check 'running'
+inline void stop_running_handler(int)
+{
+    running = false;
+}
+
+// Stops the thread that triggers shutdown_condition(). Call it before
+// finalizing the participant factory and returning from main(), so that
+// the thread does not use the condition after that.
+inline void teardown_signal_handlers()
+{
+    signal(SIGINT, stop_running_handler);
+    signal(SIGTERM, stop_running_handler);
+#ifndef _WIN32
+    if (shutdown_thread.joinable()) {
+        // A stop_handler() already running writes to -1 and fails
+        int write_end = shutdown_pipe[1];
+        shutdown_pipe[1] = -1;
+        close(write_end);  // The thread reads the end of the pipe and exits
+        shutdown_thread.join();
+        close(shutdown_pipe[0]);
+        shutdown_pipe[0] = -1;
+    }
+#endif
+}
+
+// How long a publisher waits at exit for the matched DataReaders to
+// acknowledge its last samples, which are lost if its DataWriter is deleted
+// first
+const dds::core::Duration SHUTDOWN_ACK_TIMEOUT(1);
+
+// Returns false if not all the samples were acknowledged in time
+template <typename Writer>
+bool wait_for_acknowledgments_on_exit(Writer& writer)
+{
+    try {
+        writer.wait_for_acknowledgments(SHUTDOWN_ACK_TIMEOUT);
+        return true;
+    } catch (const dds::core::TimeoutError&) {
+        std::cout << "Not all samples were acknowledged before shutting down"
+                  << std::endl;
+        return false;
+    }
+}
+
 enum class ParseReturn {
     PARSE_RETURN_OK,
     PARSE_RETURN_FAILURE,
@@ -45,6 +146,10 @@ struct ApplicationArguments {
     ParseReturn parse_result;
     unsigned int domain_id;
     unsigned int sample_count;
+    unsigned int payload_size;
+    double rate;
+    std::string qos_profile;
+    OutputMode output_mode;
     rti::config::Verbosity verbosity;
 };
 
@@ -56,6 +161,10 @@ inline ApplicationArguments parse_arguments(int argc, char *argv[])
     ParseReturn parse_result = ParseReturn::PARSE_RETURN_OK;
     unsigned int domain_id = 0;
     unsigned int sample_count = 0;  // Infinite
+    unsigned int payload_size = 0;  // Benchmark picks its default
+    double rate = 0;  // As fast as possible
+    std::string qos_profile = "hello_world_Library::LatencyShmemProfile";
+    OutputMode output_mode = OutputMode::SYNC;
     rti::config::Verbosity verbosity(rti::config::Verbosity::EXCEPTION);
 
     while (arg_processing < argc) {
@@ -73,6 +182,43 @@ inline ApplicationArguments parse_arguments(int argc, char *argv[])
                     static_cast<rti::config::Verbosity::inner_enum>(
                             atoi(argv[arg_processing + 1]));
             arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--payload-size") == 0) {
+            payload_size = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "-r") == 0
+                || strcmp(argv[arg_processing], "--rate") == 0) {
+            rate = atof(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--transport") == 0) {
+            if (strcmp(argv[arg_processing + 1], "shmem") == 0) {
+                qos_profile = "hello_world_Library::LatencyShmemProfile";
+            } else if (strcmp(argv[arg_processing + 1], "udp") == 0) {
+                qos_profile = "hello_world_Library::LatencyUdpProfile";
+            } else {
+                std::cout << "Bad transport." << std::endl;
+                show_usage = true;
+                parse_result = ParseReturn::PARSE_RETURN_FAILURE;
+                break;
+            }
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--qos-profile") == 0) {
+            qos_profile = argv[arg_processing + 1];
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "-o") == 0
+                || strcmp(argv[arg_processing], "--output") == 0) {
+            if (strcmp(argv[arg_processing + 1], "sync") == 0) {
+                output_mode = OutputMode::SYNC;
+            } else if (strcmp(argv[arg_processing + 1], "async") == 0) {
+                output_mode = OutputMode::ASYNC;
+            } else if (strcmp(argv[arg_processing + 1], "none") == 0) {
+                output_mode = OutputMode::NONE;
+            } else {
+                std::cout << "Bad output mode." << std::endl;
+                show_usage = true;
+                parse_result = ParseReturn::PARSE_RETURN_FAILURE;
+                break;
+            }
+            arg_processing += 2;
         } else if (strcmp(argv[arg_processing], "-h") == 0
                 || strcmp(argv[arg_processing], "--help") == 0) {
             std::cout << "Example application." << std::endl;
@@ -94,13 +240,38 @@ inline ApplicationArguments parse_arguments(int argc, char *argv[])
                     "    -s, --sample_count <int>   Number of samples to receive before\n"\
                     "                               cleanly shutting down. \n"
                     "                               Default: infinite\n"
+                    "    --payload-size     <int>   Ping only: characters in each\n"\
+                    "                               message, up to 255.\n"
+                    "                               Default: 16, 64 and 255 in turn\n"
+                    "    -r, --rate         <Hz>    Ping only: pings per second.\n"\
+                    "                               Default: 0 (next ping as soon as\n"
+                    "                               the reply arrives)\n"
+                    "    --transport  <shmem|udp>   Ping and pong: transport to use.\n"\
+                    "                               Both sides must use the same one.\n"
+                    "                               Default: shmem\n"
+                    "    --qos-profile      <name>  Ping and pong: QoS profile to use\n"\
+                    "                               instead of the --transport one,\n"
+                    "                               as <library>::<profile>\n"
+                    "    -o, --output <sync|async|none>\n"\
+                    "                               How to print each sample: right\n"
+                    "                               away, from a background thread\n"
+                    "                               (lines may be dropped if it falls\n"
+                    "                               behind), or not at all.\n"
+                    "                               Default: sync\n"
                     "    -v, --verbosity    <int>   How much debugging output to show.\n"\
                     "                               Range: 0-5 \n"
                     "                               Default: 0"
                 << std::endl;
     }
 
-    return { parse_result, domain_id, sample_count, verbosity };
+    return { parse_result,
+             domain_id,
+             sample_count,
+             payload_size,
+             rate,
+             qos_profile,
+             output_mode,
+             verbosity };
 }
 
 }  // namespace application
@@ -0,0 +1,247 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef CONSOLE_OUTPUT_HPP
+#define CONSOLE_OUTPUT_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace application {
+
+enum class OutputMode {
+    SYNC,   // Print each line to std::cout as it is produced
+    ASYNC,  // Queue lines for a background thread that prints them in batches
+    NONE    // Do not print per-sample lines at all
+};
+
+// Prints the per-sample lines of the examples. In ASYNC mode, print() only
+// copies the line into a lock-free queue owned by the calling thread; a
+// background thread prints the queued lines of all threads in large batches.
+// When a queue is full the line is dropped and counted, so a slow terminal
+// never slows down the DDS threads.
+class ConsoleOutput {
+public:
+    // Longest line kept in ASYNC mode. Longer lines are truncated.
+    static const size_t MAX_LINE_LENGTH = 496;
+    // Lines each thread can queue before lines are dropped
+    static const size_t QUEUE_CAPACITY = 4096;
+
+    ConsoleOutput() : mode_(OutputMode::SYNC), stopping_(false)
+    {
+    }
+
+    ~ConsoleOutput()
+    {
+        stop();
+    }
+
+    // Sets the mode. ASYNC starts the background thread.
+    void start(OutputMode mode)
+    {
+        stop();
+        mode_ = mode;
+        if (mode_ == OutputMode::ASYNC) {
+            stopping_ = false;
+            printer_thread_ = std::thread([this]() { run_printer(); });
+        }
+    }
+
+    // Prints everything queued and stops the background thread. Lines
+    // printed afterwards are printed synchronously.
+    void stop()
+    {
+        if (printer_thread_.joinable()) {
+            stopping_ = true;
+            printer_thread_.join();
+            mode_ = OutputMode::SYNC;
+
+            uint64_t dropped = dropped_lines();
+            if (dropped > 0) {
+                std::cout << dropped << " output lines were dropped"
+                          << std::endl;
+            }
+        }
+    }
+
+    // Prints all the arguments, followed by a new line
+    template <typename... Args>
+    void print(const Args&... args)
+    {
+        switch (mode_) {
+        case OutputMode::NONE:
+            return;
+        case OutputMode::SYNC: {
+            // Keep lines from different threads from mixing
+            std::lock_guard<std::mutex> lock(sync_mutex_);
+            write_all(std::cout, args...);
+            std::cout << std::endl;
+            return;
+        }
+        case OutputMode::ASYNC: {
+            // One formatting buffer per thread, reused for every line
+            thread_local std::ostringstream line;
+            line.str(std::string());
+            write_all(line, args...);
+            local_queue().push(line.str());
+            return;
+        }
+        }
+    }
+
+    // Lines dropped so far because a queue was full
+    uint64_t dropped_lines() const
+    {
+        std::lock_guard<std::mutex> lock(queues_mutex_);
+        uint64_t dropped = 0;
+        for (const auto& queue : queues_) {
+            dropped += queue->dropped.load(std::memory_order_relaxed);
+        }
+        return dropped;
+    }
+
+private:
+    // Single-producer, single-consumer ring of fixed-size lines. Only the
+    // owning thread pushes and only the printer thread pops.
+    struct LineQueue {
+        struct Line {
+            uint32_t length;
+            char text[MAX_LINE_LENGTH];
+        };
+
+        LineQueue() : lines(QUEUE_CAPACITY), head(0), tail(0), dropped(0)
+        {
+        }
+
+        void push(const std::string& text)
+        {
+            size_t current_tail = tail.load(std::memory_order_relaxed);
+            if (current_tail - head.load(std::memory_order_acquire)
+                == QUEUE_CAPACITY) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            Line& line = lines[current_tail % QUEUE_CAPACITY];
+            line.length = static_cast<uint32_t>(
+                    text.size() < MAX_LINE_LENGTH ? text.size()
+                                                  : MAX_LINE_LENGTH);
+            memcpy(line.text, text.data(), line.length);
+            tail.store(current_tail + 1, std::memory_order_release);
+        }
+
+        // Appends the queued lines to 'out'. Returns the number of lines.
+        size_t pop_all(std::vector<char>& out)
+        {
+            size_t current_head = head.load(std::memory_order_relaxed);
+            size_t current_tail = tail.load(std::memory_order_acquire);
+            for (size_t i = current_head; i != current_tail; i++) {
+                const Line& line = lines[i % QUEUE_CAPACITY];
+                out.insert(out.end(), line.text, line.text + line.length);
+                out.push_back('\n');
+            }
+            head.store(current_tail, std::memory_order_release);
+            return current_tail - current_head;
+        }
+
+        std::vector<Line> lines;
+        // head and tail are on separate cache lines, so the producer and
+        // the consumer do not invalidate each other's cache on every line
+        char padding1[64];
+        std::atomic<size_t> head;
+        char padding2[64];
+        std::atomic<size_t> tail;
+        std::atomic<uint64_t> dropped;
+    };
+
+    static void write_all(std::ostream&)
+    {
+    }
+
+    template <typename First, typename... Rest>
+    static void write_all(
+            std::ostream& out,
+            const First& first,
+            const Rest&... rest)
+    {
+        out << first;
+        write_all(out, rest...);
+    }
+
+    // The queue of the calling thread, created on first use
+    LineQueue& local_queue()
+    {
+        thread_local LineQueue *queue = nullptr;
+        if (queue == nullptr) {
+            std::lock_guard<std::mutex> lock(queues_mutex_);
+            queues_.push_back(std::unique_ptr<LineQueue>(new LineQueue()));
+            queue = queues_.back().get();
+        }
+        return *queue;
+    }
+
+    void run_printer()
+    {
+        std::vector<char> batch;
+        std::vector<LineQueue *> queues;
+        while (true) {
+            // Read stopping_ first: if it is set, the last drain below
+            // still sees every line pushed before stop() was called
+            bool stopping = stopping_;
+            {
+                std::lock_guard<std::mutex> lock(queues_mutex_);
+                queues.clear();
+                for (const auto& queue : queues_) {
+                    queues.push_back(queue.get());
+                }
+            }
+
+            size_t line_count = 0;
+            for (LineQueue *queue : queues) {
+                line_count += queue->pop_all(batch);
+            }
+            if (!batch.empty()) {
+                // One write and one flush for the whole batch
+                std::cout.write(batch.data(), batch.size());
+                std::cout.flush();
+                batch.clear();
+            }
+
+            if (stopping) {
+                return;
+            }
+            if (line_count == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+
+    std::atomic<OutputMode> mode_;
+    std::mutex sync_mutex_;
+    mutable std::mutex queues_mutex_;
+    std::vector<std::unique_ptr<LineQueue>> queues_;
+    std::atomic<bool> stopping_;
+    std::thread printer_thread_;
+};
+
+// Per-sample output of the example, configured with --output
+ConsoleOutput console;
+
+}  // namespace application
+
+#endif  // CONSOLE_OUTPUT_HPP
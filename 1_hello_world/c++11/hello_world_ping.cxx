@@ -0,0 +1,260 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+// Round-trip latency benchmark, ping side. Writes a HelloMessage on the
+// "HelloMessage Ping" Topic, waits for hello_world_pong to write it back on
+// "HelloMessage Pong", and records the round-trip time in an HDR histogram.
+// Each message starts with the number of the ping, so late replies are not
+// mistaken for the current one.
+//
+// Run hello_world_pong with the same --transport or --qos-profile, then:
+//   hello_world_ping [-s <round trips>] [--payload-size <chars>] [-r <Hz>]
+//                    [--transport shmem|udp] [--qos-profile <profile>]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dds/pub/ddspub.hpp>
+#include <dds/sub/ddssub.hpp>
+#include <dds/core/ddscore.hpp>
+#include <rti/config/Logger.hpp>  // for logging
+// Or simply include <dds/dds.hpp>
+
+#include "hello_world.hpp"
+#include "application.hpp"  // Argument parsing
+#include "hdr_histogram.hpp"
+
+using namespace application;
+
+const unsigned int DEFAULT_ROUND_TRIPS = 10000;
+// Round trips made before measuring, while caches and buffers warm up
+const unsigned int WARMUP_ROUND_TRIPS = 1000;
+// Longest message that fits in HelloMessage::msg
+const unsigned int MAX_PAYLOAD_SIZE = 255;
+// A ping with no reply after this time is counted as lost
+const std::chrono::seconds REPLY_TIMEOUT(1);
+
+// A message 'payload_size' characters long that starts with the ping number
+std::string make_payload(uint64_t number, unsigned int payload_size)
+{
+    std::string payload = std::to_string(number) + " ";
+    if (payload.size() < payload_size) {
+        payload.append(payload_size - payload.size(), 'x');
+    }
+    return payload;
+}
+
+// The ping number at the start of a message
+uint64_t ping_number(const std::string& message)
+{
+    return strtoull(message.c_str(), nullptr, 10);
+}
+
+// Waits until the pong side is matched in both directions
+void wait_for_pong(
+        dds::pub::DataWriter<HelloMessage>& writer,
+        dds::sub::DataReader<HelloMessage>& reader)
+{
+    std::cout << "Waiting for hello_world_pong..." << std::endl;
+    while (running
+           && (writer.publication_matched_status().current_count() == 0
+               || reader.subscription_matched_status().current_count() == 0)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
+
+// Measures 'round_trips' round trips with messages of 'payload_size'
+// characters, one every 1/rate seconds (or as soon as the previous reply
+// arrives when rate is 0), and prints the latency percentiles. With a rate,
+// each round trip is measured from the time the ping should have been sent,
+// so a slow reply also shows in the pings it delayed. Pings are numbered
+// from expected_number + 1, so a reply left over from an earlier
+// measurement never matches.
+void measure(
+        dds::pub::DataWriter<HelloMessage>& writer,
+        dds::sub::DataReader<HelloMessage>& reader,
+        unsigned int payload_size,
+        unsigned int round_trips,
+        double rate,
+        uint64_t& expected_number)
+{
+    typedef std::chrono::steady_clock clock;
+
+    // The handler runs in dispatch() below, when a reply is available
+    bool replied = false;
+    dds::core::cond::StatusCondition status_condition(reader);
+    status_condition.enabled_statuses(
+            dds::core::status::StatusMask::data_available());
+    status_condition.extensions().handler(
+            [&reader, &expected_number, &replied]() {
+                dds::sub::LoanedSamples<HelloMessage> samples = reader.take();
+                for (const auto& sample : samples) {
+                    if (sample.info().valid()
+                        && ping_number(sample.data().msg())
+                                == expected_number) {
+                        replied = true;
+                    }
+                }
+            });
+    dds::core::cond::WaitSet waitset;
+    waitset += status_condition;
+
+    clock::duration period = rate > 0
+            ? std::chrono::duration_cast<clock::duration>(
+                    std::chrono::duration<double>(1 / rate))
+            : clock::duration::zero();
+
+    HdrHistogram histogram;
+    unsigned int replies = 0;
+    unsigned int lost = 0;
+    HelloMessage sample;
+    auto next_send = clock::now();
+    auto start_time = next_send;
+    for (unsigned int i = 0; running && i < WARMUP_ROUND_TRIPS + round_trips;
+         i++) {
+        if (i == WARMUP_ROUND_TRIPS) {
+            start_time = clock::now();
+        }
+        expected_number++;
+        replied = false;
+        sample.msg(make_payload(expected_number, payload_size));
+
+        auto send_time = clock::now();
+        if (period > clock::duration::zero()) {
+            // A ping sent late because of a slow reply counts the delay
+            std::this_thread::sleep_until(next_send);
+            send_time = next_send;
+            next_send += period;
+        }
+        writer.write(sample);
+        auto deadline = clock::now() + REPLY_TIMEOUT;
+        while (!replied && running && clock::now() < deadline) {
+            waitset.dispatch(dds::core::Duration::from_millisecs(100));
+        }
+        auto round_trip = clock::now() - send_time;
+
+        if (!replied) {
+            lost++;
+        } else if (i >= WARMUP_ROUND_TRIPS) {
+            histogram.record(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            round_trip)
+                            .count());
+            replies++;
+        }
+    }
+    std::chrono::duration<double> elapsed = clock::now() - start_time;
+
+    std::cout << "Payload " << payload_size << " chars, "
+              << replies / std::max(elapsed.count(), 1e-9)
+              << " round trips/s, " << lost << " lost" << std::endl;
+    std::cout << "    Round trip (us): ";
+    histogram.print(std::cout, 1000);
+
+    waitset -= status_condition;
+}
+
+void run_example(
+        unsigned int domain_id,
+        unsigned int round_trips,
+        unsigned int payload_size,
+        double rate,
+        const std::string& qos_profile)
+{
+    if (round_trips == 0) {
+        round_trips = DEFAULT_ROUND_TRIPS;
+    }
+    std::vector<unsigned int> payload_sizes = { 16, 64, MAX_PAYLOAD_SIZE };
+    if (payload_size > 0) {
+        payload_sizes = { std::min(payload_size, MAX_PAYLOAD_SIZE) };
+    }
+
+    // The transport and the rest of the QoS come from one profile in
+    // USER_QOS_PROFILES.xml, selected with --transport or --qos-profile
+    dds::core::QosProvider qos_provider = dds::core::QosProvider::Default();
+    dds::domain::DomainParticipant participant(
+            domain_id,
+            qos_provider.participant_qos(qos_profile));
+
+    dds::topic::Topic<HelloMessage> ping_topic(
+            participant,
+            "HelloMessage Ping");
+    dds::topic::Topic<HelloMessage> pong_topic(
+            participant,
+            "HelloMessage Pong");
+    dds::pub::DataWriter<HelloMessage> writer(
+            dds::pub::Publisher(participant),
+            ping_topic,
+            qos_provider.datawriter_qos(qos_profile));
+    dds::sub::DataReader<HelloMessage> reader(
+            dds::sub::Subscriber(participant),
+            pong_topic,
+            qos_provider.datareader_qos(qos_profile));
+
+    wait_for_pong(writer, reader);
+    std::cout << "Measuring with " << qos_profile << std::endl;
+    uint64_t pings_sent = 0;
+    for (unsigned int size : payload_sizes) {
+        if (!running) {
+            break;
+        }
+        measure(writer, reader, size, round_trips, rate, pings_sent);
+    }
+}
+
+// Sets Connext verbosity to help debugging
+void set_verbosity(rti::config::Verbosity verbosity)
+{
+    rti::config::Logger::instance().verbosity(verbosity);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::PARSE_RETURN_EXIT) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::PARSE_RETURN_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Enables different levels of debugging output
+    set_verbosity(arguments.verbosity);
+
+    try {
+        run_example(
+                arguments.domain_id,
+                arguments.sample_count,
+                arguments.payload_size,
+                arguments.rate,
+                arguments.qos_profile);
+    } catch (const std::exception& ex) {
+        // This will catch DDS exceptions
+        std::cerr << "Exception in ping_main(): " << ex.what() << std::endl;
+        teardown_signal_handlers();
+        return EXIT_FAILURE;
+    }
+
+    teardown_signal_handlers();
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,137 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+// Round-trip latency benchmark, pong side. Writes every HelloMessage
+// received on the "HelloMessage Ping" Topic back on "HelloMessage Pong".
+// See hello_world_ping.cxx.
+//
+//   hello_world_pong [-s <replies>] [--transport shmem|udp]
+//                    [--qos-profile <profile>]
+
+#include <iostream>
+#include <string>
+
+#include <dds/pub/ddspub.hpp>
+#include <dds/sub/ddssub.hpp>
+#include <dds/core/ddscore.hpp>
+#include <rti/config/Logger.hpp>  // for logging
+// Or simply include <dds/dds.hpp>
+
+#include "hello_world.hpp"
+#include "application.hpp"  // Argument parsing
+
+using namespace application;
+
+// Writes back every ping received
+unsigned int reply(
+        dds::sub::DataReader<HelloMessage>& reader,
+        dds::pub::DataWriter<HelloMessage>& writer)
+{
+    unsigned int replies = 0;
+    dds::sub::LoanedSamples<HelloMessage> samples = reader.take();
+    for (const auto& sample : samples) {
+        if (sample.info().valid()) {
+            writer.write(sample.data());
+            replies++;
+        }
+    }
+
+    return replies;
+}  // The LoanedSamples destructor returns the loan
+
+void run_example(
+        unsigned int domain_id,
+        unsigned int reply_count,
+        const std::string& qos_profile)
+{
+    // Use the same QoS profile as hello_world_ping
+    dds::core::QosProvider qos_provider = dds::core::QosProvider::Default();
+    dds::domain::DomainParticipant participant(
+            domain_id,
+            qos_provider.participant_qos(qos_profile));
+
+    dds::topic::Topic<HelloMessage> ping_topic(
+            participant,
+            "HelloMessage Ping");
+    dds::topic::Topic<HelloMessage> pong_topic(
+            participant,
+            "HelloMessage Pong");
+    dds::sub::DataReader<HelloMessage> reader(
+            dds::sub::Subscriber(participant),
+            ping_topic,
+            qos_provider.datareader_qos(qos_profile));
+    dds::pub::DataWriter<HelloMessage> writer(
+            dds::pub::Publisher(participant),
+            pong_topic,
+            qos_provider.datawriter_qos(qos_profile));
+
+    // Reply as soon as a ping is available, in the context of the dispatch
+    // call (see below)
+    unsigned int replies = 0;
+    dds::core::cond::StatusCondition status_condition(reader);
+    status_condition.enabled_statuses(
+            dds::core::status::StatusMask::data_available());
+    status_condition.extensions().handler([&reader, &writer, &replies]() {
+        replies += reply(reader, writer);
+    });
+
+    dds::core::cond::WaitSet waitset;
+    waitset += status_condition;
+    waitset += shutdown_condition();  // Wakes it up on control-C
+
+    std::cout << "Replying to pings with " << qos_profile << std::endl;
+    while (running && (replies < reply_count || reply_count == 0)) {
+        waitset.dispatch(dds::core::Duration(4));  // Wait up to 4s each time
+    }
+    std::cout << "Replied to " << replies << " pings" << std::endl;
+}
+
+// Sets Connext verbosity to help debugging
+void set_verbosity(rti::config::Verbosity verbosity)
+{
+    rti::config::Logger::instance().verbosity(verbosity);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::PARSE_RETURN_EXIT) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::PARSE_RETURN_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Enables different levels of debugging output
+    set_verbosity(arguments.verbosity);
+
+    try {
+        run_example(
+                arguments.domain_id,
+                arguments.sample_count,
+                arguments.qos_profile);
+    } catch (const std::exception& ex) {
+        // All DDS exceptions inherit from std::exception
+        std::cerr << "Exception in pong_main(): " << ex.what() << std::endl;
+        teardown_signal_handlers();
+        return EXIT_FAILURE;
+    }
+
+    teardown_signal_handlers();
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
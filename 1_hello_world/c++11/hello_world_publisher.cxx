@@ -13,7 +13,7 @@
 #include <iostream>
 
 #include <dds/pub/ddspub.hpp>
-#include <rti/util/util.hpp>  // for sleep()
+#include <dds/core/ddscore.hpp>
 #include <rti/config/Logger.hpp>  // for logging
 // Or simply include <dds/dds.hpp> 
 
@@ -41,18 +41,25 @@ void run_example(int domain_id, int sample_count)
     // DataWriter QoS is configured in USER_QOS_PROFILES.xml
     dds::pub::DataWriter<HelloMessage> writer(publisher, topic);
 
+    // Waiting on the shutdown condition instead of sleeping lets control-C
+    // interrupt the pause between samples
+    dds::core::cond::WaitSet shutdown_waitset;
+    shutdown_waitset += shutdown_condition();
+
     // Create data sample for writing
     HelloMessage sample;
     for (int count = 0; running && (count < sample_count || sample_count == 0);
          count++) {
         // Modify the data to be written here
 
-        std::cout << "Writing HelloMessage, count " << count << std::endl;
+        console.print("Writing HelloMessage, count ", count);
 
         writer.write(sample);
 
-        rti::util::sleep(dds::core::Duration(4));
+        shutdown_waitset.dispatch(dds::core::Duration(4));
     }
+    wait_for_acknowledgments_on_exit(writer);
+    console.stop();
 }
 
 // Sets Connext verbosity to help debugging
@@ -74,6 +81,7 @@ int main(int argc, char *argv[])
 
     // Enables different levels of debugging output
     set_verbosity(arguments.verbosity);
+    console.start(arguments.output_mode);
 
     try {
         run_example(arguments.domain_id, arguments.sample_count);
@@ -81,9 +89,12 @@ int main(int argc, char *argv[])
         // This will catch DDS exceptions
         std::cerr << "Exception in publisher_main(): " << ex.what()
                   << std::endl;
+        teardown_signal_handlers();
         return EXIT_FAILURE;
     }
 
+    teardown_signal_handlers();
+
     // Releases the memory used by the participant factory.  Optional at
     // application shutdown
     dds::domain::DomainParticipant::finalize_participant_factory();
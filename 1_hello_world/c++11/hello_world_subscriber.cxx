@@ -32,7 +32,7 @@ unsigned int process_data(dds::sub::DataReader<HelloMessage>& reader)
     for (const auto& sample : samples) {
         if (sample.info().valid()) {
             samples_read++;
-            std::cout << sample.data() << std::endl;
+            console.print(sample.data());
         }
     }
 
@@ -76,15 +76,16 @@ void run_example(unsigned int domain_id, unsigned int sample_count)
     // Create a WaitSet and attach the StatusCondition
     dds::core::cond::WaitSet waitset;
     waitset += status_condition;
+    waitset += shutdown_condition();  // Wakes it up on control-C
 
     while (running && (samples_read < sample_count || sample_count == 0)) {
         // Dispatch will call the handlers associated to the WaitSet conditions
         // when they activate
-        std::cout << "HelloMessage subscriber sleeping for 4 sec..."
-                  << std::endl;
+        console.print("HelloMessage subscriber sleeping for 4 sec...");
 
         waitset.dispatch(dds::core::Duration(4));  // Wait up to 4s each time
     }
+    console.stop();
 }
 
 // Sets Connext verbosity to help debugging
@@ -106,6 +107,7 @@ int main(int argc, char *argv[])
 
     // Enables different levels of debugging output
     set_verbosity(arguments.verbosity);
+    console.start(arguments.output_mode);
 
     try {
         run_example(arguments.domain_id, arguments.sample_count);
@@ -113,9 +115,12 @@ int main(int argc, char *argv[])
         // All DDS exceptions inherit from std::exception
         std::cerr << "Exception in subscriber_main(): " << ex.what()
                   << std::endl;
+        teardown_signal_handlers();
         return EXIT_FAILURE;
     }
 
+    teardown_signal_handlers();
+
     // Releases the memory used by the participant factory.  Optional at
     // application shutdown
     dds::domain::DomainParticipant::finalize_participant_factory();
@@ -0,0 +1,247 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef CONSOLE_OUTPUT_H
+#define CONSOLE_OUTPUT_H
+
+#include <iostream>
+#include <stdarg.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <time.h>
+#endif
+
+namespace application {
+
+enum OutputMode {
+    OUTPUT_SYNC,   // Print each line to stdout as it is produced
+    OUTPUT_ASYNC,  // Queue lines for a background thread that prints them
+    OUTPUT_NONE    // Do not print per-sample lines at all
+};
+
+// C++98 has no atomics: these give the ordering the queue below needs
+inline unsigned long load_acquire(const volatile unsigned long *value)
+{
+#ifdef _WIN32
+    unsigned long result = *value;
+    MemoryBarrier();
+    return result;
+#else
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#endif
+}
+
+inline void store_release(volatile unsigned long *target, unsigned long value)
+{
+#ifdef _WIN32
+    MemoryBarrier();
+    *target = value;
+#else
+    __atomic_store_n(target, value, __ATOMIC_RELEASE);
+#endif
+}
+
+// Prints the per-sample lines of the examples. In OUTPUT_ASYNC mode, print()
+// only formats the line into a lock-free single-producer, single-consumer
+// queue; a background thread prints the queued lines in large batches. When
+// the queue is full the line is dropped and counted, so a slow terminal
+// never slows down the application thread.
+//
+// Only one thread may call print() in OUTPUT_ASYNC mode.
+class ConsoleOutput {
+public:
+    enum {
+        MAX_LINE_LENGTH = 252,  // Longer lines are truncated
+        QUEUE_CAPACITY = 4096   // Lines queued before lines are dropped
+    };
+
+    ConsoleOutput()
+            : mode_(OUTPUT_SYNC),
+              head_(0),
+              tail_(0),
+              dropped_(0),
+              stopping_(0),
+              printer_started_(false)
+    {
+    }
+
+    ~ConsoleOutput()
+    {
+        stop();
+    }
+
+    // Sets the mode. OUTPUT_ASYNC starts the background thread.
+    void start(OutputMode mode)
+    {
+        stop();
+        mode_ = mode;
+        if (mode_ != OUTPUT_ASYNC) {
+            return;
+        }
+
+        store_release(&stopping_, 0);
+#ifdef _WIN32
+        printer_thread_ =
+                CreateThread(NULL, 0, printer_thread_main, this, 0, NULL);
+        printer_started_ = (printer_thread_ != NULL);
+#else
+        printer_started_ = (pthread_create(
+                                    &printer_thread_,
+                                    NULL,
+                                    printer_thread_main,
+                                    this)
+                            == 0);
+#endif
+        if (!printer_started_) {
+            std::cerr << "Could not start the output thread" << std::endl;
+            mode_ = OUTPUT_SYNC;
+        }
+    }
+
+    // Prints everything queued and stops the background thread. Lines
+    // printed afterwards are printed synchronously.
+    void stop()
+    {
+        if (!printer_started_) {
+            return;
+        }
+
+        store_release(&stopping_, 1);
+#ifdef _WIN32
+        WaitForSingleObject(printer_thread_, INFINITE);
+        CloseHandle(printer_thread_);
+#else
+        pthread_join(printer_thread_, NULL);
+#endif
+        printer_started_ = false;
+        mode_ = OUTPUT_SYNC;
+
+        if (dropped_ > 0) {
+            std::cout << dropped_ << " output lines were dropped" << std::endl;
+        }
+    }
+
+    // Prints a line with printf-style formatting. The new line is added.
+    void print(const char *format, ...)
+    {
+        va_list args;
+
+        if (mode_ == OUTPUT_NONE) {
+            return;
+        } else if (mode_ == OUTPUT_SYNC) {
+            va_start(args, format);
+            vprintf(format, args);
+            va_end(args);
+            printf("\n");
+            fflush(stdout);
+            return;
+        }
+
+        unsigned long tail = tail_;
+        if (tail - load_acquire(&head_) == QUEUE_CAPACITY) {
+            dropped_++;
+            return;
+        }
+        Line& line = lines_[tail % QUEUE_CAPACITY];
+        va_start(args, format);
+        line.length = vsnprintf(line.text, MAX_LINE_LENGTH, format, args);
+        va_end(args);
+        if (line.length < 0) {
+            line.length = 0;
+        } else if (line.length >= MAX_LINE_LENGTH) {
+            line.length = MAX_LINE_LENGTH - 1;
+        }
+        store_release(&tail_, tail + 1);
+    }
+
+private:
+    struct Line {
+        int length;
+        char text[MAX_LINE_LENGTH];
+    };
+
+#ifdef _WIN32
+    static DWORD WINAPI printer_thread_main(LPVOID param)
+    {
+        static_cast<ConsoleOutput *>(param)->run_printer();
+        return 0;
+    }
+#else
+    static void *printer_thread_main(void *param)
+    {
+        static_cast<ConsoleOutput *>(param)->run_printer();
+        return NULL;
+    }
+#endif
+
+    void run_printer()
+    {
+        while (true) {
+            // Read stopping_ first: if it is set, the last drain below
+            // still sees every line queued before stop() was called
+            bool stopping = load_acquire(&stopping_) != 0;
+
+            // Print all queued lines, with one flush for all of them
+            unsigned long head = head_;
+            unsigned long tail = load_acquire(&tail_);
+            bool printed = (head != tail);
+            for (; head != tail; head++) {
+                const Line& line = lines_[head % QUEUE_CAPACITY];
+                fwrite(line.text, 1, line.length, stdout);
+                fputc('\n', stdout);
+            }
+            if (printed) {
+                fflush(stdout);
+                store_release(&head_, head);
+            }
+
+            if (stopping) {
+                return;
+            }
+            if (!printed) {
+                // Nothing queued: wait a millisecond
+#ifdef _WIN32
+                Sleep(1);
+#else
+                struct timespec delay = { 0, 1000000 };
+                nanosleep(&delay, NULL);
+#endif
+            }
+        }
+    }
+
+    OutputMode mode_;
+    Line lines_[QUEUE_CAPACITY];
+    // head_ is only written by the printer thread, tail_ and dropped_ only
+    // by the thread calling print()
+    volatile unsigned long head_;
+    volatile unsigned long tail_;
+    unsigned long dropped_;
+    volatile unsigned long stopping_;
+    bool printer_started_;
+#ifdef _WIN32
+    HANDLE printer_thread_;
+#else
+    pthread_t printer_thread_;
+#endif
+};
+
+// Per-sample output of the example, configured with --output
+ConsoleOutput console;
+
+}  // namespace application
+
+#endif  // CONSOLE_OUTPUT_H
@@ -92,6 +92,14 @@ int run_example(unsigned int domain_id, unsigned int sample_count)
         return shutdown(participant, "DataWriter narrow error", EXIT_FAILURE);
     }
 
+    // Waiting on the shutdown condition instead of sleeping lets control-C
+    // interrupt the pause between samples
+    DDSWaitSet shutdown_waitset;
+    retcode = shutdown_waitset.attach_condition(shutdown_condition());
+    if (retcode != DDS_RETCODE_OK) {
+        return shutdown(participant, "attach_condition error", EXIT_FAILURE);
+    }
+
     // Create data sample for writing
     HelloMessage *sample = HelloMessageTypeSupport::create_data();
     if (sample == NULL) {
@@ -108,16 +116,18 @@ int run_example(unsigned int domain_id, unsigned int sample_count)
          ++count) {
         // Modify the data to be written here
 
-        std::cout << "Writing HelloMessage, count " << count << std::endl;
+        console.print("Writing HelloMessage, count %u", count);
         retcode = HelloMessage_writer->write(*sample, DDS_HANDLE_NIL);
         if (retcode != DDS_RETCODE_OK) {
             std::cerr << "write error " << retcode << std::endl;
         }
 
         // Send every 4 seconds
+        DDSConditionSeq active_conditions_seq;
         DDS_Duration_t send_period = { 4, 0 };
-        NDDSUtility::sleep(send_period);
+        shutdown_waitset.wait(active_conditions_seq, send_period);
     }
+    wait_for_acknowledgments_on_exit(writer);
 
     // Cleanup
     // -------
@@ -140,6 +150,7 @@ static int shutdown(
 {
     DDS_ReturnCode_t retcode;
 
+    console.stop();  // Print the queued lines first
     std::cout << shutdown_message << std::endl;
 
     if (participant != NULL) {
@@ -183,9 +194,12 @@ int main(int argc, char *argv[])
 
     // Enables different levels of debugging output
     set_verbosity(arguments.verbosity);
+    console.start(arguments.output_mode);
 
     int status = run_example(arguments.domain_id, arguments.sample_count);
 
+    teardown_signal_handlers();
+
     // Releases the memory used by the participant factory.  Optional at
     // application shutdown
     DDS_ReturnCode_t retcode = DDSDomainParticipantFactory::finalize_instance();
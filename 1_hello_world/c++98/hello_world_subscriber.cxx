@@ -40,11 +40,11 @@ unsigned int process_data(HelloMessageDataReader *HelloMessage_reader)
     for (int i = 0; i < data_seq.length(); ++i) {
         // Check if a sample is an instance lifecycle event
         if (!info_seq[i].valid_data) {
-            std::cout << "Received instance state notification" << std::endl;
+            console.print("Received instance state notification");
             continue;
         }
         // Print data
-        HelloMessageTypeSupport::print_data(&data_seq[i]);
+        console.print("[msg: %s]", data_seq[i].msg);
         samples_read++;
     }
     // Data sequence was loaned from middleware for performance.
@@ -135,6 +135,13 @@ int run_example(unsigned int domain_id, unsigned int sample_count)
         shutdown(participant, "attach_condition error", EXIT_FAILURE);
     }
 
+    // Attach the shutdown condition too, so that control-C wakes the WaitSet
+    // at once
+    retcode = waitset.attach_condition(shutdown_condition());
+    if (retcode != DDS_RETCODE_OK) {
+        shutdown(participant, "attach_condition error", EXIT_FAILURE);
+    }
+
     // A narrow is a cast from a generic DataReader to one that is specific
     // to your type. Use the type specific DataReader to read data
     HelloMessageDataReader *HelloMessage_reader =
@@ -188,6 +195,7 @@ static int shutdown(
 {
     DDS_ReturnCode_t retcode;
 
+    console.stop();  // Print the queued lines first
     std::cout << shutdown_message << std::endl;
 
     if (participant != NULL) {
@@ -229,9 +237,12 @@ int main(int argc, char *argv[])
 
     // Enables different levels of debugging output
     set_verbosity(arguments.verbosity);
+    console.start(arguments.output_mode);
 
     int status = run_example(arguments.domain_id, arguments.sample_count);
 
+    teardown_signal_handlers();
+
     // Releases the memory used by the participant factory.  Optional at
     // application shutdown
     DDS_ReturnCode_t retcode = DDSDomainParticipantFactory::finalize_instance();
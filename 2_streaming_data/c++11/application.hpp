@@ -13,28 +13,144 @@
 #ifndef APPLICATION_HPP
 #define APPLICATION_HPP
 
+#include <atomic>
 #include <iostream>
 #include <csignal>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+    #include <cerrno>
+    #include <unistd.h>
+#endif
 #include <dds/core/ddscore.hpp>
 
+#include "console_output.hpp"
+#include "rate_scheduler.hpp"
+
 
 namespace application {
 
-// Catch control-C and tell application to shut down
-bool running = true;
+// Catch control-C and tell application to shut down. The signal handler
+// sets it, so it must be lock-free.
+static_assert(ATOMIC_BOOL_LOCK_FREE == 2, "running must be lock-free");
+std::atomic<bool> running(true);
+
+// Triggered on control-C. A loop that attaches it to its WaitSet wakes up
+// at once, instead of when its wait() or dispatch() times out.
+inline dds::core::cond::GuardCondition& shutdown_condition()
+{
+    static dds::core::cond::GuardCondition condition;
+    return condition;
+}
+
+inline void request_shutdown()
+{
+    std::cout << "preparing to shut down..." << std::endl;
+    shutdown_condition().trigger_value(true);
+}
+
+#ifndef _WIN32
+// A signal handler may only call async-signal-safe functions, which
+// trigger_value() is not. It writes to this pipe instead, and a thread
+// blocked reading it calls request_shutdown().
+int shutdown_pipe[2] = { -1, -1 };
+std::thread shutdown_thread;
+#endif
 
 inline void stop_handler(int)
 {
     running = false;
-    std::cout << "preparing to shut down..." << std::endl;
+#ifdef _WIN32
+    // Windows runs the handler in a thread of its own
+    request_shutdown();
+#else
+    char signal_byte = 0;
+    ssize_t written = write(shutdown_pipe[1], &signal_byte, 1);
+    (void) written;  // Without the pipe, loops stop at their next timeout
+#endif
 }
 
 inline void setup_signal_handlers()
 {
+    shutdown_condition();  // Created here, not in the signal path
+#ifndef _WIN32
+    if (pipe(shutdown_pipe) == 0) {
+        shutdown_thread = std::thread([]() {
+            char signal_byte;
+            ssize_t result;
+            while ((result = read(shutdown_pipe[0], &signal_byte, 1)) != 0) {
+                if (result == 1) {
+                    request_shutdown();
+                } else if (errno != EINTR) {
+                    break;
+                }
+            }
+        });
+    }
+#endif
     signal(SIGINT, stop_handler);
     signal(SIGTERM, stop_handler);
 }
 
+// After this, control-C only stops the loops that check 'running'
+inline void stop_running_handler(int)
+{
+    running = false;
+}
+
+// Stops the thread that triggers shutdown_condition(). Call it before
+// finalizing the participant factory and returning from main(), so that
+// the thread does not use the condition after that.
+inline void teardown_signal_handlers()
+{
+    signal(SIGINT, stop_running_handler);
+    signal(SIGTERM, stop_running_handler);
+#ifndef _WIN32
+    if (shutdown_thread.joinable()) {
+        // A stop_handler() already running writes to -1 and fails
+        int write_end = shutdown_pipe[1];
+        shutdown_pipe[1] = -1;
+        close(write_end);  // The thread reads the end of the pipe and exits
+        shutdown_thread.join();
+        close(shutdown_pipe[0]);
+        shutdown_pipe[0] = -1;
+    }
+#endif
+}
+
+// How long a publisher waits at exit for the matched DataReaders to
+// acknowledge its last samples, which are lost if its DataWriter is deleted
+// first
+const dds::core::Duration SHUTDOWN_ACK_TIMEOUT(1);
+
+// Returns false if not all the samples were acknowledged in time
+template <typename Writer>
+bool wait_for_acknowledgments_on_exit(Writer& writer)
+{
+    try {
+        writer.wait_for_acknowledgments(SHUTDOWN_ACK_TIMEOUT);
+        return true;
+    } catch (const dds::core::TimeoutError&) {
+        std::cout << "Not all samples were acknowledged before shutting down"
+                  << std::endl;
+        return false;
+    }
+}
+
+// Parses a comma-separated list of numbers, such as 1,10,60
+inline std::vector<unsigned int> parse_list(const char *list)
+{
+    std::vector<unsigned int> values;
+    while (*list != '\0') {
+        values.push_back(atoi(list));
+        list += strcspn(list, ",");
+        if (*list == ',') {
+            list++;
+        }
+    }
+    return values;
+}
+
 enum class ParseReturn {
     PARSE_RETURN_OK,
     PARSE_RETURN_FAILURE,
@@ -46,6 +162,43 @@ struct ApplicationArguments {
     unsigned int domain_id;
     unsigned int sample_count;
     std::string sensor_id;
+    unsigned int batch_size;
+    unsigned int batch_flush_us;
+    bool async_publish;
+    unsigned int flow_rate;
+    unsigned int flow_burst;
+    double rate;
+    OverrunPolicy overrun_policy;
+    unsigned int spin_us;
+    unsigned int sensors;
+    unsigned int threads;
+    unsigned int clients;
+    bool zero_copy;
+    unsigned int payload_size;
+    unsigned int workers;
+    unsigned int readers;
+    unsigned int stats_period;
+    std::vector<unsigned int> stats_windows;
+    unsigned int min_separation_ms;
+    bool latest_only;
+    std::string filter;
+    unsigned int history_seconds;
+    std::string record_directory;
+    unsigned int segment_size_mb;
+    unsigned int query_workers;
+    unsigned int query_window;
+    std::string replay_directory;
+    double replay_speed;
+    double replay_from;
+    std::vector<unsigned int> payload_sizes;
+    std::vector<unsigned int> batch_sizes;
+    std::vector<unsigned int> history_depths;
+    unsigned int duration;
+    std::string results_file;
+    std::string metrics_file;
+    unsigned int metrics_port;
+    std::string qos_profile;
+    OutputMode output_mode;
     rti::config::Verbosity verbosity;
 };
 
@@ -58,6 +211,43 @@ inline ApplicationArguments parse_arguments(int argc, char *argv[])
     unsigned int domain_id = 0;
     unsigned int sample_count = 0;  // Infinite
     std::string sensor_id;
+    unsigned int batch_size = 0;  // Batching disabled
+    unsigned int batch_flush_us = 1000;
+    bool async_publish = false;
+    unsigned int flow_rate = 0;  // Not limited
+    unsigned int flow_burst = 0;  // One period of flow_rate
+    double rate = 0;  // Publisher picks its default
+    OverrunPolicy overrun_policy = OverrunPolicy::CATCH_UP;
+    unsigned int spin_us = 0;
+    unsigned int sensors = 1;
+    unsigned int threads = 1;
+    unsigned int clients = 1;
+    bool zero_copy = false;
+    unsigned int payload_size = 0;  // All sizes from 16 B to 1 MB
+    unsigned int workers = 0;  // Process samples in the dispatch thread
+    unsigned int readers = 16;
+    unsigned int stats_period = 10;
+    std::vector<unsigned int> stats_windows = { 1, 10, 60 };
+    unsigned int min_separation_ms = 0;  // Every sample is delivered
+    bool latest_only = false;
+    std::string filter;  // Every sensor and temperature
+    unsigned int history_seconds = 0;  // No history
+    std::string record_directory;  // Not recording
+    unsigned int segment_size_mb = 64;
+    unsigned int query_workers = 0;  // No query service
+    unsigned int query_window = 0;  // Latest readings
+    std::string replay_directory;
+    double replay_speed = 1;  // Original timing
+    double replay_from = 0;  // From the start of the log
+    std::vector<unsigned int> payload_sizes = { 16, 256, 4096, 16384 };
+    std::vector<unsigned int> batch_sizes = { 0, 10, 100 };
+    std::vector<unsigned int> history_depths = { 0, 1, 100 };  // 0: keep all
+    unsigned int duration = 5;
+    std::string results_file;
+    std::string metrics_file;
+    unsigned int metrics_port = 0;  // No HTTP endpoint
+    std::string qos_profile;  // Each program picks its default profile
+    OutputMode output_mode = OutputMode::SYNC;
     rti::config::Verbosity verbosity(rti::config::Verbosity::EXCEPTION);
 
     while (arg_processing < argc) {
@@ -79,6 +269,141 @@ inline ApplicationArguments parse_arguments(int argc, char *argv[])
                 || strcmp(argv[arg_processing], "--sensor-id") == 0) {
             sensor_id = argv[arg_processing + 1];
             arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "-b") == 0
+                || strcmp(argv[arg_processing], "--batch-size") == 0) {
+            batch_size = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--batch-flush-us") == 0) {
+            batch_flush_us = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--async") == 0) {
+            async_publish = true;
+            arg_processing += 1;
+        } else if (strcmp(argv[arg_processing], "--flow-rate") == 0) {
+            flow_rate = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--flow-burst") == 0) {
+            flow_burst = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "-r") == 0
+                || strcmp(argv[arg_processing], "--rate") == 0) {
+            rate = atof(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--overrun") == 0) {
+            if (strcmp(argv[arg_processing + 1], "skip") == 0) {
+                overrun_policy = OverrunPolicy::SKIP;
+            } else if (strcmp(argv[arg_processing + 1], "catch-up") == 0) {
+                overrun_policy = OverrunPolicy::CATCH_UP;
+            } else {
+                std::cout << "Bad overrun policy." << std::endl;
+                show_usage = true;
+                parse_result = ParseReturn::PARSE_RETURN_FAILURE;
+                break;
+            }
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--spin-us") == 0) {
+            spin_us = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--sensors") == 0) {
+            sensors = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--threads") == 0) {
+            threads = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--clients") == 0) {
+            clients = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--zero-copy") == 0) {
+            zero_copy = true;
+            arg_processing += 1;
+        } else if (strcmp(argv[arg_processing], "--payload-size") == 0) {
+            payload_size = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "-w") == 0
+                || strcmp(argv[arg_processing], "--workers") == 0) {
+            workers = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--readers") == 0) {
+            readers = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--stats-period") == 0) {
+            stats_period = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--stats-windows") == 0) {
+            stats_windows = parse_list(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--min-separation") == 0) {
+            min_separation_ms = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--latest-only") == 0) {
+            latest_only = true;
+            arg_processing += 1;
+        } else if (strcmp(argv[arg_processing], "--filter") == 0) {
+            filter = argv[arg_processing + 1];
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--history") == 0) {
+            history_seconds = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--record") == 0) {
+            record_directory = argv[arg_processing + 1];
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--segment-size") == 0) {
+            segment_size_mb = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--query-workers") == 0) {
+            query_workers = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--window") == 0) {
+            query_window = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--replay") == 0) {
+            replay_directory = argv[arg_processing + 1];
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--speed") == 0) {
+            replay_speed = atof(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--from") == 0) {
+            replay_from = atof(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--payload-sizes") == 0) {
+            payload_sizes = parse_list(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--batch-sizes") == 0) {
+            batch_sizes = parse_list(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--history-depths") == 0) {
+            history_depths = parse_list(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--duration") == 0) {
+            duration = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--results") == 0) {
+            results_file = argv[arg_processing + 1];
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--metrics-file") == 0) {
+            metrics_file = argv[arg_processing + 1];
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--metrics-port") == 0) {
+            metrics_port = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--qos-profile") == 0) {
+            qos_profile = argv[arg_processing + 1];
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "-o") == 0
+                || strcmp(argv[arg_processing], "--output") == 0) {
+            if (strcmp(argv[arg_processing + 1], "sync") == 0) {
+                output_mode = OutputMode::SYNC;
+            } else if (strcmp(argv[arg_processing + 1], "async") == 0) {
+                output_mode = OutputMode::ASYNC;
+            } else if (strcmp(argv[arg_processing + 1], "none") == 0) {
+                output_mode = OutputMode::NONE;
+            } else {
+                std::cout << "Bad output mode." << std::endl;
+                show_usage = true;
+                parse_result = ParseReturn::PARSE_RETURN_FAILURE;
+                break;
+            }
+            arg_processing += 2;
         } else if (strcmp(argv[arg_processing], "-h") == 0
                 || strcmp(argv[arg_processing], "--help") == 0) {
             std::cout << "Example application." << std::endl;
@@ -102,13 +427,210 @@ inline ApplicationArguments parse_arguments(int argc, char *argv[])
                     "                               Default: infinite\n"
                     "                               cleanly shutting down. \n"
                     "    -id, --sensor-id   <int>   Unique ID of temperature sensor\n"\
+                    "    -b, --batch-size   <int>   Publisher only: number of samples\n"\
+                    "                               per batch. Writes as fast as\n"
+                    "                               possible when set.\n"
+                    "                               Default: 0 (batching disabled)\n"
+                    "    --batch-flush-us   <int>   Publisher only: maximum time in\n"\
+                    "                               microseconds a partial batch is\n"
+                    "                               held before it is sent.\n"
+                    "                               Default: 1000\n"
+                    "    --async                    Publisher only: send samples from\n"\
+                    "                               a middleware thread, so write()\n"
+                    "                               returns without waiting for the\n"
+                    "                               network.\n"
+                    "    --flow-rate        <B/s>   Publisher only: limit the bytes\n"\
+                    "                               sent per second with a\n"
+                    "                               token-bucket flow controller.\n"
+                    "                               Implies --async.\n"
+                    "                               Default: 0 (not limited)\n"
+                    "    --flow-burst       <B>     Publisher only: bytes that can be\n"\
+                    "                               sent at once after a quiet period\n"
+                    "                               when --flow-rate is set.\n"
+                    "                               Default: 10 ms of --flow-rate\n"
+                    "    -r, --rate         <Hz>    Publisher only: samples per second.\n"\
+                    "                               Default: 0.25, or as fast as\n"
+                    "                               possible when batching\n"
+                    "    --overrun    <catch-up|skip>\n"\
+                    "                               Publisher only: what to do with\n"
+                    "                               periods missed when the publisher\n"
+                    "                               falls behind.\n"
+                    "                               Default: catch-up\n"
+                    "    --spin-us          <int>   Publisher only: busy-wait for the\n"\
+                    "                               last microseconds of each period\n"
+                    "                               instead of sleeping.\n"
+                    "                               Default: 0\n"
+                    "    --sensors          <int>   Publisher only: number of sensors\n"\
+                    "                               to simulate, each one writing at\n"
+                    "                               --rate. IDs are <sensor-id>_<n>.\n"
+                    "                               --sample-count is per sensor.\n"
+                    "                               Default: 1\n"
+                    "    --threads          <int>   Publisher and replay: number of\n"\
+                    "                               writer threads the sensors are\n"
+                    "                               spread over.\n"
+                    "                               Default: 1\n"
+                    "    --clients          <int>   Query benchmark only: number of\n"\
+                    "                               client threads, each with its own\n"
+                    "                               requester.\n"
+                    "                               Default: 1\n"
+                    "    --zero-copy                Zero-copy programs only: use Zero\n"\
+                    "                               Copy transfer over shared memory\n"
+                    "                               instead of copying each sample.\n"
+                    "    --payload-size     <int>   Zero-copy publisher only: bytes of\n"\
+                    "                               payload per sample.\n"
+                    "                               Default: 16 B to 1 MB in turn\n"
+                    "    -w, --workers      <int>   Subscriber: number of threads\n"\
+                    "                               processing the samples. Samples of\n"
+                    "                               a sensor stay in order.\n"
+                    "                               Default: 0 (processed in the\n"
+                    "                               thread that takes them)\n"
+                    "    --readers          <int>   Cache benchmark only: number of\n"\
+                    "                               threads reading the cache.\n"
+                    "                               Default: 16\n"
+                    "    --stats-period     <int>   Subscriber only: seconds between\n"\
+                    "                               two summaries of the statistics\n"
+                    "                               of each sensor. 0 prints it only\n"
+                    "                               on shutdown.\n"
+                    "                               Default: 10\n"
+                    "    --stats-windows <int,...>  Subscriber only: lengths in\n"\
+                    "                               seconds of the windows the\n"
+                    "                               statistics are computed over. Each\n"
+                    "                               one must be a multiple of the\n"
+                    "                               previous one.\n"
+                    "                               Default: 1,10,60\n"
+                    "    --min-separation   <ms>    Subscriber only: deliver at most\n"\
+                    "                               one sample of each sensor per\n"
+                    "                               period (time-based filter).\n"
+                    "                               Default: 0 (every sample)\n"
+                    "    --latest-only              Subscriber only: keep only the\n"\
+                    "                               latest sample of each sensor and\n"
+                    "                               read them every --min-separation\n"
+                    "                               ms (250 ms if not set), instead\n"
+                    "                               of on every sample.\n"
+                    "    --filter           <expr>  Subscriber only: receive only the\n"\
+                    "                               samples matching this SQL filter,\n"
+                    "                               e.g. \"degrees > 31 AND sensor_id\n"
+                    "                               MATCH 'line3_*'\"\n"
+                    "    --history          <s>     Subscriber: keep the readings of\n"\
+                    "                               each sensor of the last seconds\n"
+                    "                               in memory, compressed.\n"
+                    "                               temperature_query: ask for the\n"
+                    "                               readings of -id over the last\n"
+                    "                               seconds.\n"
+                    "                               Default: 0 (no history)\n"
+                    "    --record           <dir>   Subscriber only: append every\n"\
+                    "                               sample, serialized, to a binary\n"
+                    "                               log in this directory. Use with\n"
+                    "                               --output none at high rates.\n"
+                    "    --segment-size     <MB>    Subscriber only: size of each file\n"\
+                    "                               of the --record log.\n"
+                    "                               Default: 64\n"
+                    "    --query-workers    <int>   Subscriber only: answer the\n"\
+                    "                               TemperatureQuery service with this\n"
+                    "                               number of threads.\n"
+                    "                               Default: 0 (no query service)\n"
+                    "    --window           <s>     Query programs only: ask for the\n"\
+                    "                               statistics over this subscriber\n"
+                    "                               --stats-windows window, 0 for the\n"
+                    "                               latest readings. -id queries one\n"
+                    "                               sensor, else all sensors.\n"
+                    "                               Default: 0\n"
+                    "    --replay           <dir>   Replay only: directory of the\n"\
+                    "                               log recorded with --record.\n"
+                    "    --speed            <x>     Replay only: replay N times faster\n"\
+                    "                               than recorded, or 0 for as fast\n"
+                    "                               as possible.\n"
+                    "                               Default: 1 (original timing)\n"
+                    "    --from             <s>     Replay only: start this many\n"\
+                    "                               seconds after the first sample\n"
+                    "                               of the log was received.\n"
+                    "                               Default: 0\n"
+                    "    --payload-sizes <int,...>  Throughput publisher only: payload\n"\
+                    "                               sizes in bytes to sweep.\n"
+                    "                               Default: 16,256,4096,16384\n"
+                    "    --batch-sizes   <int,...>  Throughput publisher only: batch\n"\
+                    "                               sizes to sweep, 0 for no batching.\n"
+                    "                               Default: 0,10,100\n"
+                    "    --history-depths <int,...> Throughput publisher only:\n"\
+                    "                               DataWriter history depths to\n"
+                    "                               sweep, 0 for KEEP_ALL.\n"
+                    "                               Default: 0,1,100\n"
+                    "    --duration         <int>   Throughput publisher, cache, query\n"\
+                    "                               and profile benchmarks: seconds\n"
+                    "                               each combination is measured.\n"
+                    "                               Default: 5\n"
+                    "    --results          <file>  Throughput programs only: file the\n"\
+                    "                               results are written to, as JSON\n"
+                    "                               if it ends in .json, else as CSV\n"
+                    "    --metrics-file     <file>  Publisher and subscriber only: file\n"\
+                    "                               rewritten every second with the\n"
+                    "                               metrics, in Prometheus text format\n"
+                    "    --metrics-port     <int>   Publisher and subscriber only: port\n"\
+                    "                               on 127.0.0.1 that serves the\n"
+                    "                               metrics over HTTP\n"
+                    "    --qos-profile <profile>    Publisher, subscriber, throughput\n"\
+                    "                               programs and profile benchmark\n"
+                    "                               only: QoS profile in\n"
+                    "                               USER_QOS_PROFILES.xml, such as\n"
+                    "                               ChocolateFactoryLibrary::\n"
+                    "                               LowLatencyTemperatureProfile or\n"
+                    "                               HighThroughputTemperatureProfile.\n"
+                    "                               Profile benchmark default: every\n"
+                    "                               profile in turn\n"
+                    "    -o, --output <sync|async|none>\n"\
+                    "                               How to print each sample: right\n"
+                    "                               away, from a background thread\n"
+                    "                               (lines may be dropped if it falls\n"
+                    "                               behind), or not at all.\n"
+                    "                               Default: sync\n"
                     "    -v, --verbosity    <int>   How much debugging output to show.\n"\
                     "                               Range: 0-5 \n"
                     "                               Default: 0"
                 << std::endl;
     }
 
-    return { parse_result, domain_id, sample_count, sensor_id, verbosity };
+    return { parse_result,
+             domain_id,
+             sample_count,
+             sensor_id,
+             batch_size,
+             batch_flush_us,
+             async_publish,
+             flow_rate,
+             flow_burst,
+             rate,
+             overrun_policy,
+             spin_us,
+             sensors,
+             threads,
+             clients,
+             zero_copy,
+             payload_size,
+             workers,
+             readers,
+             stats_period,
+             stats_windows,
+             min_separation_ms,
+             latest_only,
+             filter,
+             history_seconds,
+             record_directory,
+             segment_size_mb,
+             query_workers,
+             query_window,
+             replay_directory,
+             replay_speed,
+             replay_from,
+             payload_sizes,
+             batch_sizes,
+             history_depths,
+             duration,
+             results_file,
+             metrics_file,
+             metrics_port,
+             qos_profile,
+             output_mode,
+             verbosity };
 }
 
 }  // namespace application
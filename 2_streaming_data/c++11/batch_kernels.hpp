@@ -0,0 +1,485 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef BATCH_KERNELS_HPP
+#define BATCH_KERNELS_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+// The vector kernels are selected when the compiler targets AVX-512 or AVX2,
+// for example with -march=native, -mavx2 or /arch:AVX2. Otherwise the scalar
+// kernels are used.
+#if defined(__AVX512F__) || defined(__AVX2__)
+    #include <immintrin.h>
+#endif
+
+namespace application {
+
+// Histograms have one bucket per degree, and at most this many buckets
+const size_t MAX_HISTOGRAM_BUCKETS = 256;
+
+// Copies the degrees of the valid samples into 'degrees', so the kernels
+// below can process them as one contiguous array instead of reading one
+// field from each sample
+template <typename Samples>
+void gather_degrees(const Samples& samples, std::vector<int32_t>& degrees)
+{
+    degrees.clear();
+    for (const auto& sample : samples) {
+        if (sample.info().valid()) {
+            degrees.push_back(sample.data().degrees());
+        }
+    }
+}
+
+// Scalar kernels. They are used when no vector instructions are available,
+// for the elements left over after the last full vector, and as the
+// reference the benchmark compares against.
+
+inline uint64_t count_above_scalar(
+        const int32_t *values,
+        size_t count,
+        int32_t threshold)
+{
+    uint64_t result = 0;
+    for (size_t i = 0; i < count; i++) {
+        result += values[i] > threshold;
+    }
+    return result;
+}
+
+inline int64_t sum_scalar(const int32_t *values, size_t count)
+{
+    int64_t result = 0;
+    for (size_t i = 0; i < count; i++) {
+        result += values[i];
+    }
+    return result;
+}
+
+inline void min_max_scalar(
+        const int32_t *values,
+        size_t count,
+        int32_t& min,
+        int32_t& max)
+{
+    for (size_t i = 0; i < count; i++) {
+        min = std::min(min, values[i]);
+        max = std::max(max, values[i]);
+    }
+}
+
+// Adds each value to the bucket of its degree. Values below 'first' go to
+// the first bucket and values past the last bucket go to the last one.
+inline void histogram_scalar(
+        const int32_t *values,
+        size_t count,
+        int32_t first,
+        uint64_t *buckets,
+        size_t bucket_count)
+{
+    int32_t last = static_cast<int32_t>(bucket_count) - 1;
+    for (size_t i = 0; i < count; i++) {
+        int32_t bucket = std::min(std::max(values[i] - first, 0), last);
+        buckets[bucket]++;
+    }
+}
+
+// Counts bucket indexes. Temperatures repeat a lot, so the same bucket is
+// often incremented many times in a row: alternating between four copies of
+// the histogram keeps each increment from waiting for the previous one.
+class BucketCounter {
+public:
+    explicit BucketCounter(size_t bucket_count) : bucket_count_(bucket_count)
+    {
+        memset(copies_, 0, 4 * bucket_count_ * sizeof(copies_[0]));
+    }
+
+    void add(const int32_t *indexes, size_t count)
+    {
+        uint32_t *copy1 = copies_ + bucket_count_;
+        uint32_t *copy2 = copies_ + 2 * bucket_count_;
+        uint32_t *copy3 = copies_ + 3 * bucket_count_;
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            copies_[indexes[i]]++;
+            copy1[indexes[i + 1]]++;
+            copy2[indexes[i + 2]]++;
+            copy3[indexes[i + 3]]++;
+        }
+        for (; i < count; i++) {
+            copies_[indexes[i]]++;
+        }
+    }
+
+    // Adds the counts to 'buckets'
+    void add_to(uint64_t *buckets) const
+    {
+        for (size_t bucket = 0; bucket < bucket_count_; bucket++) {
+            for (size_t copy = 0; copy < 4; copy++) {
+                buckets[bucket] += copies_[copy * bucket_count_ + bucket];
+            }
+        }
+    }
+
+private:
+    size_t bucket_count_;
+    uint32_t copies_[4 * MAX_HISTOGRAM_BUCKETS];
+};
+
+#if defined(__AVX512F__)
+
+inline const char *kernel_instruction_set()
+{
+    return "AVX-512";
+}
+
+inline uint64_t count_above(
+        const int32_t *values,
+        size_t count,
+        int32_t threshold)
+{
+    // Add one to the counter of each lane above the threshold. One vector
+    // of counters per 2^31 values is enough.
+    __m512i limit = _mm512_set1_epi32(threshold);
+    __m512i one = _mm512_set1_epi32(1);
+    uint64_t result = 0;
+    size_t i = 0;
+    while (i + 16 <= count) {
+        __m512i counters = _mm512_setzero_si512();
+        size_t block_end = std::min(count, i + (size_t(1) << 31));
+        for (; i + 16 <= block_end; i += 16) {
+            __m512i v = _mm512_loadu_si512(values + i);
+            __mmask16 above = _mm512_cmpgt_epi32_mask(v, limit);
+            counters = _mm512_mask_add_epi32(counters, above, counters, one);
+        }
+        result += static_cast<uint32_t>(_mm512_reduce_add_epi32(counters));
+    }
+    return result + count_above_scalar(values + i, count - i, threshold);
+}
+
+inline int64_t sum(const int32_t *values, size_t count)
+{
+    // Widen to 64 bits so large batches cannot overflow
+    __m512i low_sum = _mm512_setzero_si512();
+    __m512i high_sum = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i v = _mm512_loadu_si512(values + i);
+        low_sum = _mm512_add_epi64(
+                low_sum,
+                _mm512_cvtepi32_epi64(_mm512_castsi512_si256(v)));
+        high_sum = _mm512_add_epi64(
+                high_sum,
+                _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(v, 1)));
+    }
+    return _mm512_reduce_add_epi64(_mm512_add_epi64(low_sum, high_sum))
+            + sum_scalar(values + i, count - i);
+}
+
+inline void min_max(
+        const int32_t *values,
+        size_t count,
+        int32_t& min,
+        int32_t& max)
+{
+    size_t i = 0;
+    if (count >= 16) {
+        __m512i min_v = _mm512_set1_epi32(min);
+        __m512i max_v = _mm512_set1_epi32(max);
+        for (; i + 16 <= count; i += 16) {
+            __m512i v = _mm512_loadu_si512(values + i);
+            min_v = _mm512_min_epi32(min_v, v);
+            max_v = _mm512_max_epi32(max_v, v);
+        }
+        min = _mm512_reduce_min_epi32(min_v);
+        max = _mm512_reduce_max_epi32(max_v);
+    }
+    min_max_scalar(values + i, count - i, min, max);
+}
+
+inline void histogram(
+        const int32_t *values,
+        size_t count,
+        int32_t first,
+        uint64_t *buckets,
+        size_t bucket_count)
+{
+    // Compute the bucket indexes 16 at a time, then count them
+    __m512i first_v = _mm512_set1_epi32(first);
+    __m512i zero = _mm512_setzero_si512();
+    __m512i last = _mm512_set1_epi32(static_cast<int32_t>(bucket_count) - 1);
+    BucketCounter counter(bucket_count);
+    int32_t indexes[256];
+    size_t i = 0;
+    while (i + 16 <= count) {
+        size_t index_count = 0;
+        for (; i + 16 <= count && index_count < 256; i += 16) {
+            __m512i v = _mm512_loadu_si512(values + i);
+            __m512i index = _mm512_min_epi32(
+                    _mm512_max_epi32(_mm512_sub_epi32(v, first_v), zero),
+                    last);
+            _mm512_storeu_si512(indexes + index_count, index);
+            index_count += 16;
+        }
+        counter.add(indexes, index_count);
+    }
+    counter.add_to(buckets);
+    histogram_scalar(values + i, count - i, first, buckets, bucket_count);
+}
+
+#elif defined(__AVX2__)
+
+inline const char *kernel_instruction_set()
+{
+    return "AVX2";
+}
+
+inline uint64_t count_above(
+        const int32_t *values,
+        size_t count,
+        int32_t threshold)
+{
+    // Each comparison sets the lanes above the threshold to -1: subtracting
+    // it counts them. One vector of counters per 2^31 values is enough.
+    __m256i limit = _mm256_set1_epi32(threshold);
+    uint64_t result = 0;
+    size_t i = 0;
+    while (i + 8 <= count) {
+        __m256i counters = _mm256_setzero_si256();
+        size_t block_end = std::min(count, i + (size_t(1) << 31));
+        for (; i + 8 <= block_end; i += 8) {
+            __m256i v = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i *>(values + i));
+            counters = _mm256_sub_epi32(
+                    counters,
+                    _mm256_cmpgt_epi32(v, limit));
+        }
+        int32_t lanes[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), counters);
+        for (int lane = 0; lane < 8; lane++) {
+            result += static_cast<uint32_t>(lanes[lane]);
+        }
+    }
+    return result + count_above_scalar(values + i, count - i, threshold);
+}
+
+inline int64_t sum(const int32_t *values, size_t count)
+{
+    // Widen to 64 bits so large batches cannot overflow
+    __m256i low_sum = _mm256_setzero_si256();
+    __m256i high_sum = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i *>(values + i));
+        low_sum = _mm256_add_epi64(
+                low_sum,
+                _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        high_sum = _mm256_add_epi64(
+                high_sum,
+                _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+    int64_t lanes[4];
+    _mm256_storeu_si256(
+            reinterpret_cast<__m256i *>(lanes),
+            _mm256_add_epi64(low_sum, high_sum));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3]
+            + sum_scalar(values + i, count - i);
+}
+
+inline void min_max(
+        const int32_t *values,
+        size_t count,
+        int32_t& min,
+        int32_t& max)
+{
+    size_t i = 0;
+    if (count >= 8) {
+        __m256i min_v = _mm256_set1_epi32(min);
+        __m256i max_v = _mm256_set1_epi32(max);
+        for (; i + 8 <= count; i += 8) {
+            __m256i v = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i *>(values + i));
+            min_v = _mm256_min_epi32(min_v, v);
+            max_v = _mm256_max_epi32(max_v, v);
+        }
+        int32_t min_lanes[8];
+        int32_t max_lanes[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(min_lanes), min_v);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(max_lanes), max_v);
+        min_max_scalar(min_lanes, 8, min, max);
+        min_max_scalar(max_lanes, 8, min, max);
+    }
+    min_max_scalar(values + i, count - i, min, max);
+}
+
+inline void histogram(
+        const int32_t *values,
+        size_t count,
+        int32_t first,
+        uint64_t *buckets,
+        size_t bucket_count)
+{
+    // Compute the bucket indexes 8 at a time, then count them
+    __m256i first_v = _mm256_set1_epi32(first);
+    __m256i zero = _mm256_setzero_si256();
+    __m256i last = _mm256_set1_epi32(static_cast<int32_t>(bucket_count) - 1);
+    BucketCounter counter(bucket_count);
+    int32_t indexes[256];
+    size_t i = 0;
+    while (i + 8 <= count) {
+        size_t index_count = 0;
+        for (; i + 8 <= count && index_count < 256; i += 8) {
+            __m256i v = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i *>(values + i));
+            __m256i index = _mm256_min_epi32(
+                    _mm256_max_epi32(_mm256_sub_epi32(v, first_v), zero),
+                    last);
+            _mm256_storeu_si256(
+                    reinterpret_cast<__m256i *>(indexes + index_count),
+                    index);
+            index_count += 8;
+        }
+        counter.add(indexes, index_count);
+    }
+    counter.add_to(buckets);
+    histogram_scalar(values + i, count - i, first, buckets, bucket_count);
+}
+
+#else
+
+inline const char *kernel_instruction_set()
+{
+    return "scalar";
+}
+
+inline uint64_t count_above(
+        const int32_t *values,
+        size_t count,
+        int32_t threshold)
+{
+    return count_above_scalar(values, count, threshold);
+}
+
+inline int64_t sum(const int32_t *values, size_t count)
+{
+    return sum_scalar(values, count);
+}
+
+inline void min_max(
+        const int32_t *values,
+        size_t count,
+        int32_t& min,
+        int32_t& max)
+{
+    min_max_scalar(values, count, min, max);
+}
+
+inline void histogram(
+        const int32_t *values,
+        size_t count,
+        int32_t first,
+        uint64_t *buckets,
+        size_t bucket_count)
+{
+    histogram_scalar(values, count, first, buckets, bucket_count);
+}
+
+#endif
+
+// Totals of all the batches of degrees received: count, mean, min, max,
+// number of values above a threshold and a histogram with one bucket per
+// degree
+class BatchSummary {
+public:
+    BatchSummary(
+            int32_t threshold,
+            int32_t histogram_first,
+            size_t bucket_count)
+            : threshold_(threshold),
+              histogram_first_(histogram_first),
+              buckets_(std::min(bucket_count, MAX_HISTOGRAM_BUCKETS), 0),
+              count_(0),
+              sum_(0),
+              above_threshold_(0),
+              min_(std::numeric_limits<int32_t>::max()),
+              max_(std::numeric_limits<int32_t>::min())
+    {
+    }
+
+    void add(const int32_t *values, size_t count)
+    {
+        count_ += count;
+        sum_ += sum(values, count);
+        above_threshold_ += count_above(values, count, threshold_);
+        min_max(values, count, min_, max_);
+        histogram(
+                values,
+                count,
+                histogram_first_,
+                buckets_.data(),
+                buckets_.size());
+    }
+
+    void add(const std::vector<int32_t>& values)
+    {
+        add(values.data(), values.size());
+    }
+
+    // Adds the degrees of the valid samples, such as the LoanedSamples
+    // returned by take()
+    template <typename Samples>
+    void add_samples(const Samples& samples)
+    {
+        gather_degrees(samples, scratch_);
+        add(scratch_);
+    }
+
+    void print(std::ostream& out) const
+    {
+        out << "Received " << count_ << " temperatures";
+        if (count_ == 0) {
+            out << std::endl;
+            return;
+        }
+        out << ": mean " << static_cast<double>(sum_) / count_ << ", min "
+            << min_ << ", max " << max_ << ", " << above_threshold_
+            << " above " << threshold_ << " degrees" << std::endl;
+        for (size_t i = 0; i < buckets_.size(); i++) {
+            if (buckets_[i] > 0) {
+                out << "    " << histogram_first_ + static_cast<int32_t>(i)
+                    << " degrees: " << buckets_[i] << std::endl;
+            }
+        }
+    }
+
+private:
+    int32_t threshold_;
+    int32_t histogram_first_;
+    std::vector<uint64_t> buckets_;
+    uint64_t count_;
+    int64_t sum_;
+    uint64_t above_threshold_;
+    int32_t min_;
+    int32_t max_;
+    std::vector<int32_t> scratch_;  // Reused by add_samples()
+};
+
+}  // namespace application
+
+#endif  // BATCH_KERNELS_HPP
@@ -0,0 +1,230 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef HDR_HISTOGRAM_HPP
+#define HDR_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+namespace application {
+
+// High Dynamic Range histogram of positive integer values, such as latencies
+// in nanoseconds. Every value up to the highest trackable value is recorded
+// with the same relative precision (by default 3 significant digits: the
+// value reported for a recorded value is at most 0.1% higher), using a fixed
+// amount of memory and O(1) time per value.
+//
+// Values are grouped in buckets that double in size: each bucket is split
+// in the same number of sub-buckets, so the sub-bucket width grows with the
+// values it holds.
+class HdrHistogram {
+public:
+    // highest_trackable_value: larger values are recorded as this value.
+    // The default is one hour in nanoseconds.
+    // significant_digits: 1 to 3. Each digit less needs about 10 times less
+    // memory.
+    explicit HdrHistogram(
+            uint64_t highest_trackable_value = 3600000000000ULL,
+            int significant_digits = 3)
+            : highest_trackable_value_(highest_trackable_value),
+              total_count_(0),
+              min_(std::numeric_limits<uint64_t>::max()),
+              max_(0),
+              sum_(0)
+    {
+        // N significant digits need 2 * 10^N sub-buckets, rounded up to a
+        // power of two (2048 for 3 digits), of which the first half overlaps
+        // the previous bucket
+        significant_digits = std::max(1, std::min(significant_digits, 3));
+        uint64_t sub_bucket_count = 2;
+        for (int i = 0; i < significant_digits; i++) {
+            sub_bucket_count *= 10;
+        }
+        sub_bucket_half_count_magnitude_ = highest_bit(sub_bucket_count - 1);
+        sub_bucket_half_count_ = 1 << sub_bucket_half_count_magnitude_;
+        sub_bucket_mask_ = 2 * sub_bucket_half_count_ - 1;
+
+        int bucket_count = 1;
+        uint64_t smallest_untrackable = 2 * sub_bucket_half_count_;
+        while (smallest_untrackable <= highest_trackable_value_) {
+            smallest_untrackable <<= 1;
+            bucket_count++;
+        }
+        counts_.resize((bucket_count + 1) * sub_bucket_half_count_, 0);
+    }
+
+    void record(uint64_t value)
+    {
+        value = std::min(value, highest_trackable_value_);
+        counts_[counts_index(value)]++;
+        total_count_++;
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+        sum_ += static_cast<double>(value);
+    }
+
+    // Records a value measured by a loop that should run every
+    // 'expected_interval'. While the loop waits for a slow response, the
+    // measurements it would have made are missing, so the histogram would
+    // look better than what a steady stream of requests sees. This also
+    // records those missing values, as HdrHistogram's
+    // recordValueWithExpectedInterval does.
+    void record_corrected(uint64_t value, uint64_t expected_interval)
+    {
+        record(value);
+        if (expected_interval == 0) {
+            return;
+        }
+        for (uint64_t missing = value - std::min(value, expected_interval);
+             missing >= expected_interval;
+             missing -= expected_interval) {
+            record(missing);
+        }
+    }
+
+    uint64_t count() const
+    {
+        return total_count_;
+    }
+
+    uint64_t min() const
+    {
+        return total_count_ > 0 ? min_ : 0;
+    }
+
+    uint64_t max() const
+    {
+        return max_;
+    }
+
+    double mean() const
+    {
+        return total_count_ > 0 ? sum_ / total_count_ : 0;
+    }
+
+    // Value below or at which 'percentile' percent of the values are
+    // (e.g. percentile(99.9))
+    uint64_t percentile(double percentile) const
+    {
+        if (total_count_ == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(
+                std::ceil(percentile / 100 * total_count_));
+        rank = std::max<uint64_t>(1, std::min(rank, total_count_));
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts_.size(); i++) {
+            seen += counts_[i];
+            if (seen >= rank) {
+                return std::min(highest_equivalent_value(i), max_);
+            }
+        }
+        return max_;
+    }
+
+    // Adds the values recorded by another histogram, created with the same
+    // parameters (e.g. one per thread, merged at the end)
+    void merge(const HdrHistogram& other)
+    {
+        for (size_t i = 0; i < counts_.size() && i < other.counts_.size();
+             i++) {
+            counts_[i] += other.counts_[i];
+        }
+        total_count_ += other.total_count_;
+        if (other.total_count_ > 0) {
+            min_ = std::min(min_, other.min_);
+            max_ = std::max(max_, other.max_);
+        }
+        sum_ += other.sum_;
+    }
+
+    void reset()
+    {
+        std::fill(counts_.begin(), counts_.end(), 0);
+        total_count_ = 0;
+        min_ = std::numeric_limits<uint64_t>::max();
+        max_ = 0;
+        sum_ = 0;
+    }
+
+    // Prints count, min, mean, p50, p90, p99, p99.9 and max, divided by
+    // 'unit' (e.g. 1000 to print nanoseconds as microseconds)
+    void print(std::ostream& out, double unit = 1) const
+    {
+        out << std::fixed << std::setprecision(1) << "count " << count()
+            << ", min " << min() / unit << ", mean " << mean() / unit
+            << ", p50 " << percentile(50) / unit << ", p90 "
+            << percentile(90) / unit << ", p99 " << percentile(99) / unit
+            << ", p99.9 " << percentile(99.9) / unit << ", max "
+            << max() / unit << std::endl;
+        out.unsetf(std::ios::floatfield);
+    }
+
+private:
+    static int highest_bit(uint64_t value)
+    {
+        int bit = 0;
+        while (value >>= 1) {
+            bit++;
+        }
+        return bit;
+    }
+
+    size_t counts_index(uint64_t value) const
+    {
+        // Bucket 0 holds the values below 2 * sub_bucket_half_count_ with a
+        // width of 1; each following bucket holds values twice as large
+        int bucket = highest_bit(value | sub_bucket_mask_)
+                - sub_bucket_half_count_magnitude_;
+        uint64_t sub_bucket = value >> bucket;
+        return static_cast<size_t>(
+                (static_cast<uint64_t>(bucket + 1)
+                 << sub_bucket_half_count_magnitude_)
+                + sub_bucket - sub_bucket_half_count_);
+    }
+
+    // Largest value that is recorded at the same index as index i
+    uint64_t highest_equivalent_value(size_t index) const
+    {
+        int bucket = static_cast<int>(index >> sub_bucket_half_count_magnitude_)
+                - 1;
+        uint64_t sub_bucket = (index & (sub_bucket_half_count_ - 1))
+                + sub_bucket_half_count_;
+        if (bucket < 0) {
+            sub_bucket -= sub_bucket_half_count_;
+            bucket = 0;
+        }
+        uint64_t lowest = sub_bucket << bucket;
+        return lowest + (uint64_t(1) << bucket) - 1;
+    }
+
+    uint64_t highest_trackable_value_;
+    int sub_bucket_half_count_magnitude_;
+    uint64_t sub_bucket_half_count_;
+    uint64_t sub_bucket_mask_;
+    std::vector<uint64_t> counts_;
+    uint64_t total_count_;
+    uint64_t min_;
+    uint64_t max_;
+    double sum_;
+};
+
+}  // namespace application
+
+#endif  // HDR_HISTOGRAM_HPP
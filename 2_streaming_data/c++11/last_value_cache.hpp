@@ -0,0 +1,254 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef LAST_VALUE_CACHE_HPP
+#define LAST_VALUE_CACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+
+namespace application {
+
+// The latest reading of every sensor, updated by one thread (the thread
+// taking the samples) and read by any number of other threads without
+// locks.
+//
+// Each sensor gets a dense index the first time it is updated, and its
+// reading lives in its own slot, protected by a sequence lock: the writer
+// makes the sequence odd while it changes the slot, and a reader retries
+// when the sequence was odd or changed while it read. Readers never block
+// the writer, and only retry when they read a slot at the same time it is
+// updated. The slots are allocated up front, for 'capacity' sensors, so
+// they never move; the updates of further sensors are dropped.
+//
+// Readers can look sensors up by ID, or resolve the index once with find()
+// and read by index, which avoids hashing the ID on every read.
+class LastValueCache {
+public:
+    static const size_t NOT_FOUND = static_cast<size_t>(-1);
+    static const unsigned int SPINS_BEFORE_YIELD = 64;
+
+    struct Reading {
+        int32_t degrees;
+        int64_t source_ns;  // Source timestamp
+        uint64_t update_count;  // Updates of the sensor so far
+    };
+
+    explicit LastValueCache(size_t capacity)
+            : capacity_(capacity),
+              storage_(new unsigned char[(capacity + 1) * sizeof(Slot)]),
+              table_size_(table_size_for(capacity)),
+              table_(new std::atomic<uint32_t>[table_size_]),
+              sensor_count_(0),
+              dropped_count_(0)
+    {
+        // operator new only aligns to 16 bytes before C++17
+        uintptr_t address = reinterpret_cast<uintptr_t>(storage_.get());
+        address = (address + alignof(Slot) - 1) & ~(alignof(Slot) - 1);
+        slots_ = reinterpret_cast<Slot *>(address);
+        for (size_t i = 0; i < capacity_; i++) {
+            new (&slots_[i]) Slot();
+        }
+        for (size_t i = 0; i < table_size_; i++) {
+            table_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    ~LastValueCache()
+    {
+        for (size_t i = 0; i < capacity_; i++) {
+            slots_[i].~Slot();
+        }
+    }
+
+    LastValueCache(const LastValueCache&) = delete;
+    LastValueCache& operator=(const LastValueCache&) = delete;
+
+    // Writer thread only. Returns false if the sensor is new and the cache
+    // is full.
+    bool update(
+            const std::string& sensor_id,
+            int32_t degrees,
+            int64_t source_ns)
+    {
+        size_t index = find(sensor_id);
+        if (index == NOT_FOUND) {
+            index = insert(sensor_id);
+            if (index == NOT_FOUND) {
+                dropped_count_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+
+        // The data is written between two fences, so readers that see the
+        // same even sequence before and after reading saw none of it change
+        Slot& slot = slots_[index];
+        uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.degrees.store(degrees, std::memory_order_relaxed);
+        slot.source_ns.store(source_ns, std::memory_order_relaxed);
+        slot.update_count.store(
+                slot.update_count.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+        return true;
+    }
+
+    // Any thread. Returns the index of a sensor, or NOT_FOUND if it has not
+    // been updated yet. The index of a sensor never changes.
+    size_t find(const std::string& sensor_id) const
+    {
+        size_t hash = std::hash<std::string>()(sensor_id);
+        for (size_t i = hash & (table_size_ - 1);;
+             i = (i + 1) & (table_size_ - 1)) {
+            uint32_t entry = table_[i].load(std::memory_order_acquire);
+            if (entry == 0) {
+                return NOT_FOUND;
+            }
+            const Slot& slot = slots_[entry - 1];
+            if (slot.hash == hash && slot.sensor_id == sensor_id) {
+                return entry - 1;
+            }
+        }
+    }
+
+    // Any thread. Copies the latest reading of the sensor at 'index' (below
+    // sensor_count()), and returns how many times the copy was retried
+    // because the writer was updating it.
+    unsigned int read(size_t index, Reading& reading) const
+    {
+        const Slot& slot = slots_[index];
+        for (unsigned int retries = 0;; retries++) {
+            // With more threads than cores, the writer may have been
+            // preempted in the middle of an update: let it finish
+            if (retries >= SPINS_BEFORE_YIELD) {
+                std::this_thread::yield();
+            }
+            uint32_t before = slot.sequence.load(std::memory_order_acquire);
+            if ((before & 1) == 0) {
+                reading.degrees = slot.degrees.load(std::memory_order_relaxed);
+                reading.source_ns =
+                        slot.source_ns.load(std::memory_order_relaxed);
+                reading.update_count =
+                        slot.update_count.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.sequence.load(std::memory_order_relaxed) == before) {
+                    return retries;
+                }
+            }
+        }
+    }
+
+    // Any thread. Returns false if the sensor has not been updated yet.
+    bool read(const std::string& sensor_id, Reading& reading) const
+    {
+        size_t index = find(sensor_id);
+        if (index == NOT_FOUND) {
+            return false;
+        }
+        read(index, reading);
+        return true;
+    }
+
+    // Any thread. The sensors have the indexes 0 to sensor_count() - 1.
+    size_t sensor_count() const
+    {
+        return sensor_count_.load(std::memory_order_acquire);
+    }
+
+    // Any thread, for an index below sensor_count()
+    const std::string& sensor_id(size_t index) const
+    {
+        return slots_[index].sensor_id;
+    }
+
+    size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    // Updates dropped because the cache was full
+    uint64_t dropped_count() const
+    {
+        return dropped_count_.load(std::memory_order_relaxed);
+    }
+
+private:
+    // A cache line per slot, so updating a sensor does not make the
+    // readers of its neighbours retry or miss the cache
+    struct alignas(64) Slot {
+        Slot() : sequence(0), degrees(0), source_ns(0), update_count(0)
+        {
+        }
+
+        std::atomic<uint32_t> sequence;
+        std::atomic<int32_t> degrees;
+        std::atomic<int64_t> source_ns;
+        std::atomic<uint64_t> update_count;
+        // Written once, before the slot is published
+        std::string sensor_id;
+        size_t hash;
+    };
+
+    // An open-addressing table at most half full, so lookups stay short
+    static size_t table_size_for(size_t capacity)
+    {
+        size_t size = 1;
+        while (size < 2 * capacity) {
+            size *= 2;
+        }
+        return size;
+    }
+
+    // Fills the next slot with the sensor ID, then publishes it to the
+    // readers: the table entry and the sensor count are stored with release
+    // semantics after the ID is written.
+    size_t insert(const std::string& sensor_id)
+    {
+        size_t index = sensor_count_.load(std::memory_order_relaxed);
+        if (index == capacity_) {
+            return NOT_FOUND;
+        }
+        Slot& slot = slots_[index];
+        slot.sensor_id = sensor_id;
+        slot.hash = std::hash<std::string>()(sensor_id);
+
+        size_t i = slot.hash & (table_size_ - 1);
+        while (table_[i].load(std::memory_order_relaxed) != 0) {
+            i = (i + 1) & (table_size_ - 1);
+        }
+        table_[i].store(static_cast<uint32_t>(index + 1),
+                        std::memory_order_release);
+        sensor_count_.store(index + 1, std::memory_order_release);
+        return index;
+    }
+
+    size_t capacity_;
+    std::unique_ptr<unsigned char[]> storage_;
+    Slot *slots_;  // In storage_, aligned to a cache line
+    size_t table_size_;
+    // Index + 1 of the slot of each sensor, 0 for an empty entry
+    std::unique_ptr<std::atomic<uint32_t>[]> table_;
+    std::atomic<size_t> sensor_count_;
+    std::atomic<uint64_t> dropped_count_;
+};
+
+}  // namespace application
+
+#endif  // LAST_VALUE_CACHE_HPP
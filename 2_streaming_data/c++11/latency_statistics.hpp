@@ -0,0 +1,195 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef LATENCY_STATISTICS_HPP
+#define LATENCY_STATISTICS_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "hdr_histogram.hpp"
+
+namespace application {
+
+// Latency histograms of the samples of each sensor, from the timestamps of
+// each sample:
+//   - delivery: from the source timestamp (set by the DataWriter) to the
+//     reception timestamp (set when the DataReader received it). The time
+//     spent in the middleware and the network.
+//   - queueing: from the reception timestamp to the time the application
+//     took the sample. The time it waited in the DataReader queue, for
+//     example while the application was busy with earlier samples.
+//   - total: from the source timestamp to the time the application took it.
+//
+// Times are in nanoseconds since the epoch. When the publisher runs on
+// another host, delivery and total latencies include the offset between
+// the clocks of the two hosts. Samples with a source timestamp later than
+// their reception timestamp are recorded as 0 and counted.
+//
+// Only the first max_sensors sensors have their own histograms, to bound
+// the memory used; the rest are only counted in the totals. Not
+// thread-safe.
+class LatencyStatistics {
+public:
+    typedef std::chrono::steady_clock clock;
+
+    explicit LatencyStatistics(
+            std::chrono::seconds report_period = std::chrono::seconds(10),
+            size_t max_sensors = 100)
+            : report_period_(report_period),
+              next_report_(clock::now() + report_period),
+              max_sensors_(max_sensors),
+              clock_skew_count_(0)
+    {
+    }
+
+    void add(
+            const std::string& sensor_id,
+            int64_t source_ns,
+            int64_t reception_ns,
+            int64_t taken_ns)
+    {
+        uint64_t delivery = elapsed(source_ns, reception_ns);
+        uint64_t queueing = elapsed(reception_ns, taken_ns);
+        uint64_t total = elapsed(source_ns, taken_ns);
+        if (reception_ns < source_ns) {
+            clock_skew_count_++;
+        }
+
+        all_.record(delivery, queueing, total);
+        Histograms *sensor = find_sensor(sensor_id);
+        if (sensor != nullptr) {
+            sensor->record(delivery, queueing, total);
+        }
+    }
+
+    // True when the periodic summary should be printed
+    bool report_due(clock::time_point now) const
+    {
+        return report_period_.count() > 0 && now >= next_report_;
+    }
+
+    // Prints, in microseconds, the latencies of up to max_sensors sensors
+    // and of all the sensors together, since the start
+    void print_summary(
+            std::ostream& out,
+            clock::time_point now,
+            size_t max_sensors = 10)
+    {
+        out << "Latency (us) of " << all_.total.count() << " samples"
+            << std::endl;
+        size_t printed = 0;
+        for (const auto& entry : sensor_indexes_) {
+            if (printed == max_sensors) {
+                break;
+            }
+            out << "  " << entry.first << ":" << std::endl;
+            sensors_[entry.second]->print(out);
+            printed++;
+        }
+        if (printed < sensor_indexes_.size()) {
+            out << "  (" << sensor_indexes_.size() - printed
+                << " more sensors)" << std::endl;
+        }
+        if (sensors_.size() == max_sensors_) {
+            out << "  (only the first " << max_sensors_
+                << " sensors have their own histograms)" << std::endl;
+        }
+        out << "  All sensors:" << std::endl;
+        all_.print(out);
+        if (clock_skew_count_ > 0) {
+            out << "  " << clock_skew_count_
+                << " samples were received before their source timestamp:"
+                   " the clocks of the publisher and subscriber hosts differ"
+                << std::endl;
+        }
+
+        while (next_report_ <= now) {
+            next_report_ += report_period_;
+        }
+    }
+
+private:
+    // Histograms of one sensor. Two significant digits keep each one to a
+    // few tens of KB.
+    struct Histograms {
+        Histograms()
+                : delivery(HIGHEST_LATENCY_NS, 2),
+                  queueing(HIGHEST_LATENCY_NS, 2),
+                  total(HIGHEST_LATENCY_NS, 2)
+        {
+        }
+
+        void record(
+                uint64_t delivery_ns,
+                uint64_t queueing_ns,
+                uint64_t total_ns)
+        {
+            delivery.record(delivery_ns);
+            queueing.record(queueing_ns);
+            total.record(total_ns);
+        }
+
+        void print(std::ostream& out) const
+        {
+            out << "    delivery: ";
+            delivery.print(out, 1000);
+            out << "    queueing: ";
+            queueing.print(out, 1000);
+            out << "    total:    ";
+            total.print(out, 1000);
+        }
+
+        HdrHistogram delivery;
+        HdrHistogram queueing;
+        HdrHistogram total;
+    };
+
+    // Longer latencies are recorded as 60 s
+    static const uint64_t HIGHEST_LATENCY_NS = 60000000000ULL;
+
+    static uint64_t elapsed(int64_t from_ns, int64_t to_ns)
+    {
+        return to_ns > from_ns ? static_cast<uint64_t>(to_ns - from_ns) : 0;
+    }
+
+    Histograms *find_sensor(const std::string& sensor_id)
+    {
+        auto found = sensor_indexes_.find(sensor_id);
+        if (found != sensor_indexes_.end()) {
+            return sensors_[found->second].get();
+        }
+        if (sensors_.size() >= max_sensors_) {
+            return nullptr;
+        }
+        sensor_indexes_[sensor_id] = sensors_.size();
+        sensors_.push_back(std::unique_ptr<Histograms>(new Histograms()));
+        return sensors_.back().get();
+    }
+
+    std::chrono::seconds report_period_;
+    clock::time_point next_report_;
+    size_t max_sensors_;
+    uint64_t clock_skew_count_;
+    Histograms all_;
+    std::unordered_map<std::string, size_t> sensor_indexes_;
+    std::vector<std::unique_ptr<Histograms>> sensors_;
+};
+
+}  // namespace application
+
+#endif  // LATENCY_STATISTICS_HPP
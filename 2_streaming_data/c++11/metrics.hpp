@@ -0,0 +1,442 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX  // Keep windows.h from defining min and max
+    #endif
+    #include <winsock2.h>  // Link with ws2_32.lib
+    #include <ws2tcpip.h>
+#else
+    #include <arpa/inet.h>
+    #include <netinet/in.h>
+    #include <sys/select.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#endif
+
+namespace application {
+
+// Counters that any thread can increment at the cost of an uncontended
+// memory write. Each thread adds to its own copy of the counters, kept in a
+// block of memory padded to whole cache lines, so threads never write to
+// the same cache line. Reading a counter adds up the copies of all the
+// threads.
+class MetricsRegistry {
+public:
+    static const size_t MAX_COUNTERS = 32;
+
+    class Counter {
+    public:
+        Counter() : registry_(nullptr), index_(0)
+        {
+        }
+
+        void add(uint64_t value = 1)
+        {
+            registry_->add(index_, value);
+        }
+
+    private:
+        friend class MetricsRegistry;
+
+        Counter(MetricsRegistry *registry, size_t index)
+                : registry_(registry), index_(index)
+        {
+        }
+
+        MetricsRegistry *registry_;
+        size_t index_;
+    };
+
+    MetricsRegistry() : id_(next_id())
+    {
+    }
+
+    // Returns the counter with this name, creating it the first time.
+    // 'scale' converts the counted value to the exported one, for example
+    // 1e-9 to count nanoseconds and export seconds.
+    Counter counter(
+            const std::string& name,
+            const std::string& help,
+            double scale = 1)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < descriptions_.size(); i++) {
+            if (descriptions_[i].name == name) {
+                return Counter(this, i);
+            }
+        }
+        if (descriptions_.size() == MAX_COUNTERS) {
+            throw std::length_error("Too many counters: " + name);
+        }
+        Description description = { name, help, scale };
+        descriptions_.push_back(description);
+        return Counter(this, descriptions_.size() - 1);
+    }
+
+    // Writes all the counters in Prometheus text format
+    void write_prometheus(std::ostream& out) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < descriptions_.size(); i++) {
+            uint64_t total = 0;
+            for (const auto& shard : shards_) {
+                total += shard->values[i].load(std::memory_order_relaxed);
+            }
+            const Description& description = descriptions_[i];
+            out << "# HELP " << description.name << " " << description.help
+                << "\n# TYPE " << description.name << " counter\n"
+                << description.name << " ";
+            if (description.scale == 1) {
+                out << total << "\n";
+            } else {
+                out << total * description.scale << "\n";
+            }
+        }
+    }
+
+private:
+    struct Description {
+        std::string name;
+        std::string help;
+        double scale;
+    };
+
+    // The counters of one thread. The padding keeps the values of two
+    // threads out of the same 64-byte cache line, wherever the allocator
+    // places them.
+    struct Shard {
+        Shard()
+        {
+            for (auto& value : values) {
+                value.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        char padding_before[64];
+        std::atomic<uint64_t> values[MAX_COUNTERS];
+        char padding_after[64];
+    };
+
+    static uint64_t next_id()
+    {
+        static std::atomic<uint64_t> id(1);
+        return id++;
+    }
+
+    void add(size_t index, uint64_t value)
+    {
+        // Only this thread writes to its shard, so a plain load and store
+        // are enough: no locked read-modify-write instruction is needed
+        std::atomic<uint64_t>& counter = local_shard().values[index];
+        counter.store(
+                counter.load(std::memory_order_relaxed) + value,
+                std::memory_order_relaxed);
+    }
+
+    // The shard of the calling thread, created the first time the thread
+    // adds to a counter. The registry ID, not its address, identifies the
+    // registry, since a new registry could be created at the address of an
+    // old one.
+    Shard& local_shard()
+    {
+        struct LocalShard {
+            uint64_t registry_id;
+            Shard *shard;
+        };
+        static thread_local LocalShard local = { 0, nullptr };
+        if (local.registry_id != id_) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            shards_.push_back(std::unique_ptr<Shard>(new Shard()));
+            local.registry_id = id_;
+            local.shard = shards_.back().get();
+        }
+        return *local.shard;
+    }
+
+    uint64_t id_;
+    mutable std::mutex mutex_;
+    std::vector<Description> descriptions_;
+    // The shards of exited threads are kept, so their counts are not lost
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+// The counters of the application. A function-local static, so that every
+// translation unit that includes this header shares the same registry.
+inline MetricsRegistry& metrics()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+// Exports the counters of a registry, and values read from DDS entities when
+// they are exported (such as status counts), in Prometheus text format:
+//   - to a file, rewritten every second. The file is replaced in one step,
+//     so a reader never sees it half written.
+//   - over HTTP on the loopback interface. Any request on the port returns
+//     the metrics, e.g. http://127.0.0.1:<port>/metrics
+// Does nothing when neither a file nor a port is given.
+class MetricsExporter {
+public:
+    typedef std::function<double()> Source;
+
+    MetricsExporter(
+            const MetricsRegistry& registry,
+            const std::string& file_name,
+            unsigned int port)
+            : registry_(registry),
+              file_name_(file_name),
+              port_(port),
+              listener_(INVALID_LISTENER),
+              stopping_(false)
+    {
+    }
+
+    ~MetricsExporter()
+    {
+        stop();
+    }
+
+    // Adds a value read when the metrics are exported. 'type' is "counter"
+    // or "gauge". Add them all before start().
+    void add(
+            const std::string& name,
+            const std::string& help,
+            const std::string& type,
+            Source source)
+    {
+        Value value = { name, help, type, source };
+        values_.push_back(value);
+    }
+
+    void start()
+    {
+        if (port_ > 0) {
+            open_listener();
+        }
+        if (port_ > 0 || !file_name_.empty()) {
+            stopping_ = false;
+            exporter_thread_ = std::thread([this]() { run(); });
+        }
+    }
+
+    // Writes the file a last time and stops the exporter thread
+    void stop()
+    {
+        if (exporter_thread_.joinable()) {
+            stopping_ = true;
+            exporter_thread_.join();
+        }
+        if (listener_ != INVALID_LISTENER) {
+            close_socket(listener_);
+            listener_ = INVALID_LISTENER;
+#ifdef _WIN32
+            WSACleanup();
+#endif
+        }
+    }
+
+    // All the metrics, in Prometheus text format
+    std::string text() const
+    {
+        std::ostringstream out;
+        out.precision(15);  // The default 6 digits would round large counts
+        registry_.write_prometheus(out);
+        for (const auto& value : values_) {
+            out << "# HELP " << value.name << " " << value.help
+                << "\n# TYPE " << value.name << " " << value.type << "\n"
+                << value.name << " " << value.source() << "\n";
+        }
+        return out.str();
+    }
+
+private:
+#ifdef _WIN32
+    typedef SOCKET socket_type;
+    static const socket_type INVALID_LISTENER = INVALID_SOCKET;
+#else
+    typedef int socket_type;
+    static const socket_type INVALID_LISTENER = -1;
+#endif
+
+    struct Value {
+        std::string name;
+        std::string help;
+        std::string type;
+        Source source;
+    };
+
+    static void close_socket(socket_type socket)
+    {
+#ifdef _WIN32
+        closesocket(socket);
+#else
+        close(socket);
+#endif
+    }
+
+    // Waits up to timeout_ms for the socket to be readable
+    static bool wait_readable(socket_type socket, int timeout_ms)
+    {
+        fd_set sockets;
+        FD_ZERO(&sockets);
+        FD_SET(socket, &sockets);
+        struct timeval timeout;
+        timeout.tv_sec = timeout_ms / 1000;
+        timeout.tv_usec = (timeout_ms % 1000) * 1000;
+        return select(static_cast<int>(socket) + 1,
+                      &sockets,
+                      nullptr,
+                      nullptr,
+                      &timeout)
+                > 0;
+    }
+
+    void open_listener()
+    {
+#ifdef _WIN32
+        WSADATA wsa_data;
+        WSAStartup(MAKEWORD(2, 2), &wsa_data);
+#endif
+        listener_ = socket(AF_INET, SOCK_STREAM, 0);
+        if (listener_ == INVALID_LISTENER) {
+            throw std::runtime_error("Could not create the metrics socket");
+        }
+        int reuse = 1;
+        setsockopt(
+                listener_,
+                SOL_SOCKET,
+                SO_REUSEADDR,
+                reinterpret_cast<const char *>(&reuse),
+                sizeof(reuse));
+
+        // Only reachable from this host
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(static_cast<uint16_t>(port_));
+        if (bind(listener_,
+                 reinterpret_cast<struct sockaddr *>(&address),
+                 sizeof(address))
+                    != 0
+            || listen(listener_, 4) != 0) {
+            close_socket(listener_);
+            listener_ = INVALID_LISTENER;
+            throw std::runtime_error(
+                    "Could not listen on port " + std::to_string(port_));
+        }
+    }
+
+    // Answers one request with the metrics
+    void serve(socket_type client)
+    {
+        // The request itself does not matter, but it has to be read before
+        // answering, or some clients see the connection reset
+        char request[4096];
+        if (wait_readable(client, 1000)) {
+            recv(client, request, sizeof(request), 0);
+        }
+
+        std::string body = text();
+        std::string response =
+                "HTTP/1.0 200 OK\r\n"
+                "Content-Type: text/plain; version=0.0.4\r\n"
+                "Content-Length: "
+                + std::to_string(body.size())
+                + "\r\n"
+                  "Connection: close\r\n\r\n"
+                + body;
+        size_t sent = 0;
+        while (sent < response.size()) {
+            int result = send(
+                    client,
+                    response.data() + sent,
+                    static_cast<int>(response.size() - sent),
+                    0);
+            if (result <= 0) {
+                break;
+            }
+            sent += result;
+        }
+        close_socket(client);
+    }
+
+    void write_file()
+    {
+        std::string temporary_name = file_name_ + ".tmp";
+        {
+            std::ofstream file(temporary_name.c_str());
+            file << text();
+        }
+#ifdef _WIN32
+        std::remove(file_name_.c_str());  // rename() does not replace it
+#endif
+        std::rename(temporary_name.c_str(), file_name_.c_str());
+    }
+
+    void run()
+    {
+        auto next_write = std::chrono::steady_clock::now();
+        while (!stopping_) {
+            if (!file_name_.empty()
+                && std::chrono::steady_clock::now() >= next_write) {
+                write_file();
+                next_write += std::chrono::seconds(1);
+            }
+
+            // Check for stop() every 100 ms
+            if (listener_ == INVALID_LISTENER) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            } else if (wait_readable(listener_, 100)) {
+                socket_type client = accept(listener_, nullptr, nullptr);
+                if (client != INVALID_LISTENER) {
+                    serve(client);
+                }
+            }
+        }
+        if (!file_name_.empty()) {
+            write_file();
+        }
+    }
+
+    const MetricsRegistry& registry_;
+    std::string file_name_;
+    unsigned int port_;
+    std::vector<Value> values_;
+    socket_type listener_;
+    std::atomic<bool> stopping_;
+    std::thread exporter_thread_;
+};
+
+}  // namespace application
+
+#endif  // METRICS_HPP
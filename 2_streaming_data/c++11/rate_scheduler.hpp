@@ -0,0 +1,238 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef RATE_SCHEDULER_HPP
+#define RATE_SCHEDULER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+
+namespace application {
+
+// Cleared on control-C (see application.hpp)
+extern std::atomic<bool> running;
+
+// The longest a RateScheduler sleeps before checking 'running' again
+const std::chrono::milliseconds RATE_SCHEDULER_MAX_SLEEP(100);
+
+// What to do when the loop falls behind its schedule
+enum class OverrunPolicy {
+    CATCH_UP,  // Run the missed periods back-to-back until on schedule
+    SKIP       // Drop the missed periods and continue from the next one
+};
+
+// Paces a loop at a fixed rate using absolute deadlines on a monotonic
+// clock. Because each deadline is computed from the start time rather than
+// from the end of the previous iteration, the time spent in the loop body
+// does not make the rate drift. Control-C interrupts a wait, so a slow rate
+// does not delay shutting down by up to a period.
+//
+// The schedule starts at the first wait(), not when the scheduler is
+// created, so that setting up the rest of the application does not put the
+// loop behind schedule. The achieved rate is measured until stop(), so that
+// what the loop does after its last period (such as waiting for the
+// DataReaders to acknowledge the last samples) does not lower it.
+class RateScheduler {
+public:
+    typedef std::chrono::steady_clock clock;
+
+    // rate_hz: periods per second. 0 means unpaced (wait() never blocks).
+    // spin: how long before the deadline to stop sleeping and busy-wait.
+    //       Sleeping alone usually wakes up tens of microseconds late.
+    RateScheduler(
+            double rate_hz,
+            OverrunPolicy policy = OverrunPolicy::CATCH_UP,
+            std::chrono::nanoseconds spin = std::chrono::nanoseconds(0))
+            : period_(
+                    rate_hz > 0 ? std::chrono::nanoseconds(
+                            static_cast<int64_t>(std::llround(1e9 / rate_hz)))
+                                : std::chrono::nanoseconds(0)),
+              policy_(policy),
+              spin_(spin),
+              start_(clock::now()),
+              next_deadline_(start_),
+              end_(start_),
+              started_(false),
+              stopped_(false),
+              periods_(0),
+              skipped_(0),
+              paced_by_deadlines_(false),
+              jitter_mean_ns_(0),
+              jitter_m2_(0),
+              jitter_max_ns_(0)
+    {
+    }
+
+    // Blocks until the next period starts. The first call returns
+    // immediately. Returns false if control-C interrupted it.
+    bool wait()
+    {
+        start();
+        if (period_.count() == 0) {
+            periods_++;
+            return true;
+        }
+
+        clock::time_point now;
+        if (!sleep_until(next_deadline_, now)) {
+            return false;
+        }
+        record_jitter(now - next_deadline_);
+        periods_++;
+        next_deadline_ += period_;
+
+        // More than a full period late: either keep the missed periods and
+        // run them back-to-back, or forget about them
+        if (policy_ == OverrunPolicy::SKIP && now >= next_deadline_) {
+            int64_t missed = (now - next_deadline_) / period_ + 1;
+            skipped_ += static_cast<uint64_t>(missed);
+            next_deadline_ += missed * period_;
+        }
+        return true;
+    }
+
+    // Blocks until 'deadline', for loops paced by their own deadlines
+    // rather than a fixed rate (such as replaying recorded timestamps). A
+    // deadline already past returns right away, and its lateness is
+    // recorded like the lateness of a period. Returns false if control-C
+    // interrupted it.
+    bool wait_until(clock::time_point deadline)
+    {
+        start();
+        clock::time_point now;
+        if (!sleep_until(deadline, now)) {
+            return false;
+        }
+        record_jitter(now - deadline);
+        periods_++;
+        paced_by_deadlines_ = true;
+        return true;
+    }
+
+    // Ends the time the achieved rate is measured over. Call it when the
+    // loop ends; otherwise print_report() measures until it is called.
+    void stop()
+    {
+        if (!stopped_) {
+            end_ = clock::now();
+            stopped_ = true;
+        }
+    }
+
+    // Number of periods completed so far
+    uint64_t periods() const
+    {
+        return periods_;
+    }
+
+    // Number of periods dropped by the SKIP policy
+    uint64_t skipped() const
+    {
+        return skipped_;
+    }
+
+    // Prints the achieved rate and how late each period started
+    void print_report(std::ostream& out) const
+    {
+        std::chrono::duration<double> elapsed =
+                (stopped_ ? end_ : clock::now()) - start_;
+        out << "Periods: " << periods_ << ", skipped: " << skipped_
+            << ", achieved rate: "
+            << (elapsed.count() > 0 ? periods_ / elapsed.count() : 0)
+            << " Hz";
+        if (period_.count() > 0) {
+            out << " (target "
+                << 1e9 / static_cast<double>(period_.count()) << " Hz)";
+        }
+        if (period_.count() > 0 || paced_by_deadlines_) {
+            out << "\nSchedule jitter: mean " << jitter_mean_ns_ / 1000.0
+                << " us, stddev " << jitter_stddev_ns() / 1000.0
+                << " us, max " << jitter_max_ns_ / 1000.0 << " us";
+        }
+        out << std::endl;
+    }
+
+private:
+    // The first period starts now
+    void start()
+    {
+        if (!started_) {
+            start_ = clock::now();
+            next_deadline_ = start_;
+            started_ = true;
+        }
+    }
+
+    // Sleeps until 'spin' before the deadline, RATE_SCHEDULER_MAX_SLEEP at
+    // most at a time, then busy-waits. Sets 'now' to the time it woke up.
+    // Returns false if control-C interrupted it before the deadline.
+    bool sleep_until(clock::time_point deadline, clock::time_point& now) const
+    {
+        now = clock::now();
+        while (now < deadline - spin_) {
+            if (!running) {
+                return false;
+            }
+            std::this_thread::sleep_until(std::min<clock::time_point>(
+                    deadline - spin_,
+                    now + RATE_SCHEDULER_MAX_SLEEP));
+            now = clock::now();
+        }
+        while (now < deadline) {
+            // Spin for the last few microseconds
+            now = clock::now();
+        }
+        return true;
+    }
+
+    void record_jitter(clock::duration lateness)
+    {
+        // Welford's online mean and variance
+        double ns = static_cast<double>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(lateness)
+                        .count());
+        uint64_t n = periods_ + 1;
+        double delta = ns - jitter_mean_ns_;
+        jitter_mean_ns_ += delta / n;
+        jitter_m2_ += delta * (ns - jitter_mean_ns_);
+        jitter_max_ns_ = std::max(jitter_max_ns_, ns);
+    }
+
+    double jitter_stddev_ns() const
+    {
+        return periods_ > 1 ? std::sqrt(jitter_m2_ / (periods_ - 1)) : 0;
+    }
+
+    std::chrono::nanoseconds period_;
+    OverrunPolicy policy_;
+    std::chrono::nanoseconds spin_;
+    clock::time_point start_;
+    clock::time_point next_deadline_;
+    clock::time_point end_;
+    bool started_;
+    bool stopped_;
+    uint64_t periods_;
+    uint64_t skipped_;
+    bool paced_by_deadlines_;
+    double jitter_mean_ns_;
+    double jitter_m2_;
+    double jitter_max_ns_;
+};
+
+}  // namespace application
+
+#endif  // RATE_SCHEDULER_HPP
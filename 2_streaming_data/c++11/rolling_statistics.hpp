@@ -0,0 +1,430 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef ROLLING_STATISTICS_HPP
+#define ROLLING_STATISTICS_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace application {
+
+// Min, max, mean, standard deviation and rate of the temperature of each
+// sensor over a few rolling time windows (by default 1 s, 10 s and 60 s).
+//
+// Time is divided into buckets. A sample only updates the open bucket of its
+// sensor, so adding a sample costs the same however long the windows are.
+// When a bucket closes it is copied into a small ring per window, and the
+// statistics of a window are computed from its ring when they are printed.
+// The windows end at the last closed bucket, so a 60 s window after a 10 s
+// window moves in 10 s steps.
+//
+// The open buckets of all the sensors are kept together, apart from the
+// rings, so the memory touched for each sample stays small with many
+// sensors. Not thread-safe: use one RollingStatistics per thread.
+class RollingStatistics {
+public:
+    typedef std::chrono::steady_clock clock;
+
+    // Statistics of one window
+    struct Summary {
+        uint64_t count;
+        int32_t min;
+        int32_t max;
+        double mean;
+        double stddev;
+        double rate;  // Samples per second
+    };
+
+    // The statistics of one sensor over each window, shortest first
+    typedef std::vector<Summary> WindowSummaries;
+
+    // windows: the window lengths, shortest first. Each one must be a
+    // multiple of the previous one.
+    explicit RollingStatistics(
+            const std::vector<std::chrono::seconds>& windows,
+            std::chrono::seconds report_period = std::chrono::seconds(10))
+            : windows_(windows),
+              report_period_(report_period),
+              start_(clock::now()),
+              next_report_(start_ + report_period),
+              slots_per_sensor_(0)
+    {
+        if (windows_.empty()) {
+            throw std::invalid_argument("At least one window is needed");
+        }
+        for (size_t i = 0; i < windows_.size(); i++) {
+            if (windows_[i].count() <= 0
+                || (i > 0 && windows_[i].count() % windows_[i - 1].count())
+                || (i > 0 && windows_[i] <= windows_[i - 1])) {
+                throw std::invalid_argument(
+                        "Each window must be a multiple of the previous one");
+            }
+        }
+
+        // Window 0 keeps the last closed bucket. Window 1 keeps its length
+        // in buckets. Each following window keeps buckets as long as the
+        // previous window, built by adding up the previous ring.
+        bucket_period_ = std::chrono::duration_cast<clock::duration>(
+                windows_[0]);
+        for (size_t i = 0; i < windows_.size(); i++) {
+            int64_t width = i < 2 ? 1 : windows_[i - 1] / windows_[0];
+            int64_t length = i == 0 ? 1 : windows_[i] / windows_[i - 1];
+            Ring ring = { width, length, slots_per_sensor_ };
+            rings_.push_back(ring);
+            slots_per_sensor_ += length;
+        }
+        // The last window starts up to one of its buckets before its length
+        max_gap_ = (windows_.back() + windows_[0] * rings_.back().width)
+                / windows_[0];
+    }
+
+    // Adds a sample received at 'time'
+    void add(
+            const std::string& sensor_id,
+            int32_t degrees,
+            clock::time_point time)
+    {
+        int64_t period = period_of(time);
+        auto found = sensor_indexes_.find(sensor_id);
+        uint32_t index = 0;
+        if (found != sensor_indexes_.end()) {
+            index = found->second;
+        } else {
+            index = add_sensor(sensor_id, degrees, period);
+        }
+
+        SensorState& state = sensors_[index];
+        if (period != state.period) {
+            advance(index, period);
+        }
+        state.open.add(degrees - state.reference, degrees);
+    }
+
+    // True when the periodic summary should be printed
+    bool report_due(clock::time_point now) const
+    {
+        return report_period_.count() > 0 && now >= next_report_;
+    }
+
+    size_t sensor_count() const
+    {
+        return sensors_.size();
+    }
+
+    // Statistics of every sensor over every window, as print_summary()
+    // would print them
+    std::unordered_map<std::string, WindowSummaries> all_summaries(
+            clock::time_point now)
+    {
+        int64_t period = period_of(now);
+        std::unordered_map<std::string, WindowSummaries> result(
+                sensor_indexes_.size());
+        for (const auto& entry : sensor_indexes_) {
+            uint32_t index = entry.second;
+            advance(index, period);
+            WindowSummaries& summaries = result[entry.first];
+            summaries.reserve(windows_.size());
+            for (size_t i = 0; i < windows_.size(); i++) {
+                summaries.push_back(summarize(
+                        window_bucket(index, i),
+                        i,
+                        sensors_[index].reference));
+            }
+        }
+        return result;
+    }
+
+    // When the bucket open at 'time' closes. The statistics of the windows
+    // only change then.
+    clock::time_point bucket_end(clock::time_point time) const
+    {
+        return start_ + (period_of(time) + 1) * bucket_period_;
+    }
+
+    const std::vector<std::chrono::seconds>& windows() const
+    {
+        return windows_;
+    }
+
+    // Prints the statistics of up to max_sensors sensors, and of all the
+    // sensors together
+    void print_summary(
+            std::ostream& out,
+            clock::time_point now,
+            size_t max_sensors = 10)
+    {
+        int64_t period = period_of(now);
+        std::vector<Bucket> totals(windows_.size());
+        for (auto& total : totals) {
+            total.clear();
+        }
+
+        out << "Rolling statistics of " << sensors_.size() << " sensors"
+            << std::endl;
+        size_t printed = 0;
+        for (const auto& entry : sensor_indexes_) {
+            uint32_t index = entry.second;
+            // Close the buckets of the sensors that stopped publishing
+            advance(index, period);
+
+            bool print = printed < max_sensors;
+            if (print) {
+                out << "  " << entry.first << ":" << std::endl;
+                printed++;
+            }
+            for (size_t i = 0; i < windows_.size(); i++) {
+                Bucket window = window_bucket(index, i);
+                int32_t reference = sensors_[index].reference;
+                if (print) {
+                    print_window(out, i, summarize(window, i, reference));
+                }
+                // Different sensors have different reference values
+                window.add_offset(reference);
+                totals[i].merge(window);
+            }
+        }
+        if (printed < sensors_.size()) {
+            out << "  (" << sensors_.size() - printed << " more sensors)"
+                << std::endl;
+        }
+        out << "  All sensors:" << std::endl;
+        for (size_t i = 0; i < windows_.size(); i++) {
+            print_window(out, i, summarize(totals[i], i, 0));
+        }
+
+        while (next_report_ <= now) {
+            next_report_ += report_period_;
+        }
+    }
+
+private:
+    // Samples of one sensor in one bucket. Sums are relative to the first
+    // value received from the sensor, to keep the variance accurate.
+    struct Bucket {
+        uint32_t count;
+        int32_t min;
+        int32_t max;
+        double sum;
+        double sum_squares;
+
+        void clear()
+        {
+            count = 0;
+            min = std::numeric_limits<int32_t>::max();
+            max = std::numeric_limits<int32_t>::min();
+            sum = 0;
+            sum_squares = 0;
+        }
+
+        void add(double delta, int32_t value)
+        {
+            count++;
+            min = std::min(min, value);
+            max = std::max(max, value);
+            sum += delta;
+            sum_squares += delta * delta;
+        }
+
+        void merge(const Bucket& other)
+        {
+            count += other.count;
+            min = std::min(min, other.min);
+            max = std::max(max, other.max);
+            sum += other.sum;
+            sum_squares += other.sum_squares;
+        }
+
+        // Makes the sums relative to 0 instead of 'reference'
+        void add_offset(double reference)
+        {
+            sum_squares += 2 * reference * sum + count * reference * reference;
+            sum += count * reference;
+        }
+    };
+
+    // The open bucket of a sensor, which every sample updates
+    struct SensorState {
+        Bucket open;
+        int64_t period;  // Bucket period the open bucket belongs to
+        int32_t reference;
+    };
+
+    // Where the closed buckets of a window are kept
+    struct Ring {
+        int64_t width;   // Bucket length, in bucket periods
+        int64_t length;  // Number of buckets
+        int64_t offset;  // First slot in each sensor's slots
+    };
+
+    int64_t period_of(clock::time_point time) const
+    {
+        return (time - start_) / bucket_period_;
+    }
+
+    uint32_t add_sensor(
+            const std::string& sensor_id,
+            int32_t degrees,
+            int64_t period)
+    {
+        uint32_t index = static_cast<uint32_t>(sensors_.size());
+        sensor_indexes_[sensor_id] = index;
+
+        SensorState state;
+        state.open.clear();
+        state.period = period;
+        state.reference = degrees;
+        sensors_.push_back(state);
+
+        Bucket empty;
+        empty.clear();
+        slots_.resize(slots_.size() + slots_per_sensor_, empty);
+        return index;
+    }
+
+    Bucket *slots_of(uint32_t index)
+    {
+        return &slots_[index * slots_per_sensor_];
+    }
+
+    // Closes the open bucket of a sensor, and the empty buckets after it,
+    // until 'period'
+    void advance(uint32_t index, int64_t period)
+    {
+        SensorState& state = sensors_[index];
+        if (period <= state.period) {
+            return;
+        }
+
+        if (period - state.period > max_gap_) {
+            // Silent for longer than the longest window: nothing is left
+            Bucket *slots = slots_of(index);
+            for (int64_t i = 0; i < slots_per_sensor_; i++) {
+                slots[i].clear();
+            }
+        } else {
+            close_bucket(index, state.period, state.open);
+            Bucket empty;
+            empty.clear();
+            for (int64_t p = state.period + 1; p < period; p++) {
+                close_bucket(index, p, empty);
+            }
+        }
+        state.open.clear();
+        state.period = period;
+    }
+
+    void close_bucket(uint32_t index, int64_t period, const Bucket& bucket)
+    {
+        Bucket *slots = slots_of(index);
+        for (size_t i = 0; i < rings_.size() && i < 2; i++) {
+            const Ring& ring = rings_[i];
+            slots[ring.offset + period % ring.length] = bucket;
+        }
+
+        // A longer bucket closes when the previous ring has just filled up
+        // with the buckets it is made of
+        for (size_t i = 2; i < rings_.size(); i++) {
+            const Ring& ring = rings_[i];
+            if ((period + 1) % ring.width != 0) {
+                break;  // The longer buckets cannot close either
+            }
+            const Ring& previous = rings_[i - 1];
+            Bucket longer;
+            longer.clear();
+            for (int64_t j = 0; j < previous.length; j++) {
+                longer.merge(slots[previous.offset + j]);
+            }
+            int64_t longer_period = (period + 1) / ring.width - 1;
+            slots[ring.offset + longer_period % ring.length] = longer;
+        }
+    }
+
+    // All the closed buckets of a window
+    Bucket window_bucket(uint32_t index, size_t window)
+    {
+        const Ring& ring = rings_[window];
+        const Bucket *slots = slots_of(index) + ring.offset;
+        Bucket result;
+        result.clear();
+        for (int64_t i = 0; i < ring.length; i++) {
+            result.merge(slots[i]);
+        }
+        return result;
+    }
+
+    // Statistics of a window, given the value its sums are relative to
+    Summary summarize(const Bucket& bucket, size_t window, double reference)
+            const
+    {
+        Summary summary;
+        summary.count = bucket.count;
+        summary.min = bucket.min;
+        summary.max = bucket.max;
+        summary.mean = 0;
+        summary.stddev = 0;
+        summary.rate = bucket.count / static_cast<double>(
+                windows_[window].count());
+        if (bucket.count > 0) {
+            double n = bucket.count;
+            summary.mean = reference + bucket.sum / n;
+            if (bucket.count > 1) {
+                double variance = (bucket.sum_squares
+                                   - bucket.sum * bucket.sum / n)
+                        / (n - 1);
+                summary.stddev = std::sqrt(std::max(0.0, variance));
+            }
+        }
+        return summary;
+    }
+
+    void print_window(
+            std::ostream& out,
+            size_t window,
+            const Summary& summary) const
+    {
+        out << "    " << windows_[window].count() << " s: ";
+        if (summary.count == 0) {
+            out << "no samples" << std::endl;
+            return;
+        }
+        out << summary.count << " samples, " << summary.rate
+            << " samples/s, min " << summary.min << ", max " << summary.max
+            << ", mean " << summary.mean << ", stddev " << summary.stddev
+            << std::endl;
+    }
+
+    std::vector<std::chrono::seconds> windows_;
+    std::chrono::seconds report_period_;
+    clock::time_point start_;
+    clock::time_point next_report_;
+    clock::duration bucket_period_;
+    std::vector<Ring> rings_;
+    int64_t slots_per_sensor_;
+    int64_t max_gap_;  // In bucket periods
+
+    std::unordered_map<std::string, uint32_t> sensor_indexes_;
+    std::vector<SensorState> sensors_;  // Open buckets, by sensor index
+    std::vector<Bucket> slots_;  // Closed buckets, slots_per_sensor_ each
+};
+
+}  // namespace application
+
+#endif  // ROLLING_STATISTICS_HPP
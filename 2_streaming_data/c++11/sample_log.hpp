@@ -0,0 +1,550 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef SAMPLE_LOG_HPP
+#define SAMPLE_LOG_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include <dds/topic/ddstopic.hpp>  // topic_type_support
+
+namespace application {
+
+// Binary log of serialized samples, split in segments of a fixed size.
+//
+// Each segment is a file <directory>/segment_<n>.log, created at its full
+// size up front and mapped in memory: appending a sample is a copy into
+// the mapping, with no system call. The dirty pages are handed to the
+// operating system to write (msync) every sync_bytes, and the segment is
+// written completely when it is closed. Only the current segment is
+// mapped, so the memory used is bounded by the segment size.
+//
+// Segment layout, all integers in the byte order of the host:
+//   - SegmentHeader (64 bytes)
+//   - records: a RecordHeader followed by the serialized sample (CDR),
+//     padded to 8 bytes. A record header with a size of 0 (the zeroes of
+//     the preallocated file) ends the segment.
+//
+// Next to each segment, segment_<n>.idx holds a sparse time index: an
+// IndexEntry (reception timestamp and offset of a record) for the first
+// record of the segment and then at most one every index_period_ns, so a
+// reader can seek to a point in time without scanning the whole segment.
+class SampleLog {
+public:
+    static const uint32_t VERSION = 1;
+
+    struct SegmentHeader {
+        char magic[8];  // "DDSLOG\0\0"
+        uint32_t version;
+        uint32_t header_size;
+        uint64_t segment_number;
+        char reserved[40];
+    };
+
+    struct RecordHeader {
+        uint32_t size;  // Of the serialized sample, without padding
+        uint32_t reserved;
+        int64_t source_ns;  // Source timestamp, ns since the epoch
+        int64_t reception_ns;  // Reception timestamp, ns since the epoch
+    };
+
+    struct IndexEntry {
+        int64_t reception_ns;
+        uint64_t offset;  // Of the RecordHeader in the segment
+    };
+
+    static std::string segment_name(
+            const std::string& directory,
+            uint64_t segment_number,
+            const char *extension)
+    {
+        std::ostringstream name;
+        name << directory << "/segment_" << std::setw(6) << std::setfill('0')
+             << segment_number << extension;
+        return name.str();
+    }
+
+    // Records are aligned to 8 bytes, so the headers can be read in place
+    static uint64_t padded_size(uint64_t size)
+    {
+        return (size + 7) & ~static_cast<uint64_t>(7);
+    }
+};
+
+// Appends samples to a SampleLog. Not thread-safe. Only available on POSIX
+// systems.
+class SampleLogWriter {
+public:
+    // Creates 'directory' if needed. It must not hold a log already.
+    SampleLogWriter(
+            const std::string& directory,
+            uint64_t segment_size = 64 * 1024 * 1024,
+            uint64_t sync_bytes = 4 * 1024 * 1024,
+            int64_t index_period_ns = 10000000)
+            : directory_(directory),
+              segment_size_(SampleLog::padded_size(segment_size)),
+              sync_bytes_(sync_bytes),
+              index_period_ns_(index_period_ns),
+              page_size_(4096),
+              segment_number_(0),
+              file_(-1),
+              index_file_(nullptr),
+              mapping_(nullptr),
+              offset_(0),
+              synced_offset_(0),
+              last_index_ns_(0),
+              segment_count_(0),
+              record_count_(0),
+              byte_count_(0)
+    {
+#ifdef _WIN32
+        throw std::runtime_error("Recording needs a POSIX system");
+#else
+        if (segment_size_ < 2 * sizeof(SampleLog::SegmentHeader)) {
+            throw std::invalid_argument("Segment size too small");
+        }
+        if (mkdir(directory_.c_str(), 0755) != 0 && errno != EEXIST) {
+            throw std::runtime_error("Could not create " + directory_);
+        }
+        std::string first_segment =
+                SampleLog::segment_name(directory_, 0, ".log");
+        if (access(first_segment.c_str(), F_OK) == 0) {
+            throw std::runtime_error(directory_ + " already holds a recording");
+        }
+        page_size_ = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        open_segment();
+#endif
+    }
+
+    ~SampleLogWriter()
+    {
+        close_segment();
+    }
+
+    SampleLogWriter(const SampleLogWriter&) = delete;
+    SampleLogWriter& operator=(const SampleLogWriter&) = delete;
+
+    // Serializes the sample and appends it with its timestamps. The
+    // serialization buffer is reused, so once it has grown to the size of
+    // the largest sample no memory is allocated.
+    template <typename T>
+    void append(const T& sample, int64_t source_ns, int64_t reception_ns)
+    {
+        dds::topic::topic_type_support<T>::to_cdr_buffer(cdr_buffer_, sample);
+        append(cdr_buffer_.data(), cdr_buffer_.size(), source_ns, reception_ns);
+    }
+
+    void append(
+            const char *data,
+            size_t size,
+            int64_t source_ns,
+            int64_t reception_ns)
+    {
+        uint64_t record_size =
+                sizeof(SampleLog::RecordHeader) + SampleLog::padded_size(size);
+        // Leave room for the empty header that ends the segment
+        uint64_t available = segment_size_ - sizeof(SampleLog::RecordHeader);
+        if (record_size > available - sizeof(SampleLog::SegmentHeader)) {
+            throw std::length_error("Sample larger than a log segment");
+        }
+        if (offset_ + record_size > available) {
+            close_segment();
+            segment_number_++;
+            open_segment();
+        }
+
+        if (offset_ == sizeof(SampleLog::SegmentHeader)
+            || reception_ns - last_index_ns_ >= index_period_ns_) {
+            SampleLog::IndexEntry entry = { reception_ns, offset_ };
+            std::fwrite(&entry, sizeof(entry), 1, index_file_);
+            last_index_ns_ = reception_ns;
+        }
+
+        SampleLog::RecordHeader header = {
+            static_cast<uint32_t>(size),
+            0,
+            source_ns,
+            reception_ns
+        };
+        memcpy(mapping_ + offset_, &header, sizeof(header));
+        memcpy(mapping_ + offset_ + sizeof(header), data, size);
+        offset_ += record_size;
+        record_count_++;
+        byte_count_ += size;
+
+        if (offset_ - synced_offset_ >= sync_bytes_) {
+            sync(MS_ASYNC);
+        }
+    }
+
+    uint64_t segment_count() const
+    {
+        return segment_count_;
+    }
+
+    uint64_t record_count() const
+    {
+        return record_count_;
+    }
+
+    // Bytes of serialized samples, without the headers
+    uint64_t byte_count() const
+    {
+        return byte_count_;
+    }
+
+private:
+#ifdef _WIN32
+    static const int MS_ASYNC = 0;
+    static const int MS_SYNC = 0;
+#endif
+
+    void open_segment()
+    {
+#ifndef _WIN32
+        std::string name = SampleLog::segment_name(
+                directory_,
+                segment_number_,
+                ".log");
+        file_ = open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (file_ < 0) {
+            throw std::runtime_error("Could not create " + name);
+        }
+        // Reserve the disk blocks now: running out of space while writing
+        // to the mapping would kill the process with SIGBUS
+    #ifdef __linux__
+        int result = posix_fallocate(file_, 0, segment_size_);
+    #else
+        int result = ftruncate(file_, segment_size_);
+    #endif
+        void *mapping = result == 0
+                ? mmap(nullptr,
+                       segment_size_,
+                       PROT_READ | PROT_WRITE,
+                       MAP_SHARED,
+                       file_,
+                       0)
+                : MAP_FAILED;
+        if (mapping == MAP_FAILED) {
+            close(file_);
+            file_ = -1;
+            throw std::runtime_error("Could not allocate " + name);
+        }
+        mapping_ = static_cast<char *>(mapping);
+        madvise(mapping_, segment_size_, MADV_SEQUENTIAL);
+
+        std::string index_name = SampleLog::segment_name(
+                directory_,
+                segment_number_,
+                ".idx");
+        index_file_ = std::fopen(index_name.c_str(), "wb");
+        if (index_file_ == nullptr) {
+            munmap(mapping_, segment_size_);
+            mapping_ = nullptr;
+            close(file_);
+            file_ = -1;
+            throw std::runtime_error("Could not create " + index_name);
+        }
+
+        SampleLog::SegmentHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, "DDSLOG", 6);
+        header.version = SampleLog::VERSION;
+        header.header_size = sizeof(header);
+        header.segment_number = segment_number_;
+        memcpy(mapping_, &header, sizeof(header));
+        offset_ = sizeof(header);
+        synced_offset_ = 0;
+        segment_count_++;
+#endif
+    }
+
+    // Writes the whole segment to disk, and trims the unused space
+    void close_segment()
+    {
+#ifndef _WIN32
+        if (mapping_ == nullptr) {
+            return;
+        }
+        sync(MS_SYNC);
+        munmap(mapping_, segment_size_);
+        mapping_ = nullptr;
+        // Keep room for the empty record header that ends the segment
+        if (ftruncate(file_, offset_ + sizeof(SampleLog::RecordHeader)) != 0) {
+            // The segment is still readable at its full size
+        }
+        close(file_);
+        file_ = -1;
+        std::fclose(index_file_);
+        index_file_ = nullptr;
+#endif
+    }
+
+    // Writes the pages modified since the last call: MS_ASYNC starts
+    // writing them in the background, MS_SYNC waits until they are written
+    void sync(int flags)
+    {
+#ifndef _WIN32
+        uint64_t start = synced_offset_ - synced_offset_ % page_size_;
+        msync(mapping_ + start, offset_ - start, flags);
+        synced_offset_ = offset_;
+#else
+        (void) flags;
+#endif
+    }
+
+    std::string directory_;
+    uint64_t segment_size_;
+    uint64_t sync_bytes_;
+    int64_t index_period_ns_;
+    uint64_t page_size_;
+    uint64_t segment_number_;
+    int file_;
+    std::FILE *index_file_;
+    char *mapping_;
+    uint64_t offset_;
+    uint64_t synced_offset_;
+    int64_t last_index_ns_;
+    uint64_t segment_count_;
+    uint64_t record_count_;
+    uint64_t byte_count_;
+    std::vector<char> cdr_buffer_;
+};
+
+// Reads the records of a SampleLog in order, one segment after the other,
+// or from a point in time found with the time index. Each segment is mapped
+// read-only while it is read, so the log is not copied into memory. Not
+// thread-safe. Only available on POSIX systems.
+class SampleLogReader {
+public:
+    // A record, valid until the next call to next()
+    struct Record {
+        const SampleLog::RecordHeader *header;
+        const char *data;
+    };
+
+    explicit SampleLogReader(const std::string& directory)
+            : directory_(directory),
+              segment_number_(0),
+              mapping_(nullptr),
+              mapping_size_(0),
+              offset_(0)
+    {
+#ifdef _WIN32
+        throw std::runtime_error("Replay needs a POSIX system");
+#else
+        if (!open_segment()) {
+            throw std::runtime_error("No recording in " + directory_);
+        }
+#endif
+    }
+
+    ~SampleLogReader()
+    {
+        close_segment();
+    }
+
+    SampleLogReader(const SampleLogReader&) = delete;
+    SampleLogReader& operator=(const SampleLogReader&) = delete;
+
+    // Returns false after the last record of the last segment
+    bool next(Record& record)
+    {
+        while (mapping_ != nullptr) {
+            if (offset_ + sizeof(SampleLog::RecordHeader) <= mapping_size_) {
+                const SampleLog::RecordHeader *header =
+                        reinterpret_cast<const SampleLog::RecordHeader *>(
+                                mapping_ + offset_);
+                uint64_t record_size = sizeof(SampleLog::RecordHeader)
+                        + SampleLog::padded_size(header->size);
+                if (header->size > 0
+                    && offset_ + record_size <= mapping_size_) {
+                    record.header = header;
+                    record.data = mapping_ + offset_ + sizeof(*header);
+                    offset_ += record_size;
+                    return true;
+                }
+            }
+            // End of this segment
+            close_segment();
+            segment_number_++;
+            open_segment();
+        }
+        return false;
+    }
+
+    // Moves to the first record received at or after 'reception_ns', so
+    // that next() returns it. The index gives the segment and the last
+    // indexed record before that time; only the records after it, at most
+    // one index period of them, are read to find it. Returns false if no
+    // record was received at or after that time.
+    bool seek(int64_t reception_ns)
+    {
+        // The last segment that starts at or before that time: the first
+        // entry of each index is the first record of its segment
+        uint64_t segment_number = 0;
+        for (uint64_t n = 0;; n++) {
+            std::vector<SampleLog::IndexEntry> first_entry = read_index(n, 1);
+            if (first_entry.empty()
+                || first_entry.front().reception_ns > reception_ns) {
+                break;
+            }
+            segment_number = n;
+        }
+        std::vector<SampleLog::IndexEntry> index =
+                read_index(segment_number, 0);
+
+        close_segment();
+        segment_number_ = segment_number;
+        if (!open_segment()) {
+            return false;
+        }
+        for (const auto& entry : index) {
+            if (entry.reception_ns > reception_ns) {
+                break;
+            }
+            if (entry.offset + sizeof(SampleLog::RecordHeader)
+                <= mapping_size_) {
+                offset_ = entry.offset;
+            }
+        }
+
+        Record record;
+        while (next(record)) {
+            if (record.header->reception_ns >= reception_ns) {
+                // Read it again with the next call to next()
+                offset_ -= sizeof(SampleLog::RecordHeader)
+                        + SampleLog::padded_size(record.header->size);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Deserializes the sample of a record. The buffer is reused, so once it
+    // has grown to the size of the largest sample no memory is allocated
+    // for it.
+    template <typename T>
+    void read_sample(const Record& record, T& sample)
+    {
+        cdr_buffer_.assign(record.data, record.data + record.header->size);
+        dds::topic::topic_type_support<T>::from_cdr_buffer(sample, cdr_buffer_);
+    }
+
+private:
+    // Reads the first 'max_entries' entries of the index of a segment, or
+    // all of them when 0. Empty if the segment has no index.
+    std::vector<SampleLog::IndexEntry> read_index(
+            uint64_t segment_number,
+            size_t max_entries) const
+    {
+        std::vector<SampleLog::IndexEntry> index;
+        std::string name = SampleLog::segment_name(
+                directory_,
+                segment_number,
+                ".idx");
+        std::FILE *file = std::fopen(name.c_str(), "rb");
+        if (file == nullptr) {
+            return index;
+        }
+        SampleLog::IndexEntry entry;
+        while ((max_entries == 0 || index.size() < max_entries)
+               && std::fread(&entry, sizeof(entry), 1, file) == 1) {
+            index.push_back(entry);
+        }
+        std::fclose(file);
+        return index;
+    }
+
+    // Returns false if the segment does not exist
+    bool open_segment()
+    {
+#ifndef _WIN32
+        std::string name = SampleLog::segment_name(
+                directory_,
+                segment_number_,
+                ".log");
+        int file = open(name.c_str(), O_RDONLY);
+        if (file < 0) {
+            return false;
+        }
+        struct stat file_status;
+        void *mapping = MAP_FAILED;
+        if (fstat(file, &file_status) == 0
+            && static_cast<uint64_t>(file_status.st_size)
+                    >= sizeof(SampleLog::SegmentHeader)) {
+            mapping_size_ = static_cast<uint64_t>(file_status.st_size);
+            mapping = mmap(
+                    nullptr,
+                    mapping_size_,
+                    PROT_READ,
+                    MAP_SHARED,
+                    file,
+                    0);
+        }
+        close(file);  // The mapping stays valid
+        if (mapping == MAP_FAILED) {
+            throw std::runtime_error("Could not read " + name);
+        }
+        madvise(mapping, mapping_size_, MADV_SEQUENTIAL);
+        mapping_ = static_cast<const char *>(mapping);
+
+        const SampleLog::SegmentHeader *header =
+                reinterpret_cast<const SampleLog::SegmentHeader *>(mapping_);
+        if (memcmp(header->magic, "DDSLOG", 6) != 0
+            || header->version != SampleLog::VERSION) {
+            close_segment();
+            throw std::runtime_error(name + " is not a sample log");
+        }
+        offset_ = header->header_size;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void close_segment()
+    {
+#ifndef _WIN32
+        if (mapping_ != nullptr) {
+            munmap(const_cast<char *>(mapping_), mapping_size_);
+            mapping_ = nullptr;
+        }
+#endif
+    }
+
+    std::string directory_;
+    uint64_t segment_number_;
+    const char *mapping_;
+    uint64_t mapping_size_;
+    uint64_t offset_;
+    std::vector<char> cdr_buffer_;
+};
+
+}  // namespace application
+
+#endif  // SAMPLE_LOG_HPP
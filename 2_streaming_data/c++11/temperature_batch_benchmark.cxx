@@ -0,0 +1,245 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+// Measures the cost per sample of computing the totals of a batch of
+// Temperature samples returned by a DataReader: count above a threshold,
+// sum, min, max and histogram. It compares:
+//   - scalar: one loop over the LoanedSamples, reading each sample in turn,
+//     like the loop in process_data()
+//   - gather: only copying the degrees of the samples to an array
+//   - gather + kernels: the batch path of the subscriber, which gathers
+//     the degrees and runs the kernels in batch_kernels.hpp over them
+//   - kernels: the kernels alone, over the gathered degrees
+//
+// The kernels use AVX-512 or AVX2 when the compiler targets them, for
+// example with -march=native. The instruction set used is printed.
+//
+// Usage: temperature_batch_benchmark [-d <domain>] [-s <samples>]
+//   -s is the number of samples in the batch. Default: 1000
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define HAS_CYCLE_COUNTER 1
+#elif defined(_M_X64) || defined(_M_IX86)
+    #include <intrin.h>
+    #define HAS_CYCLE_COUNTER 1
+#endif
+
+#include <dds/pub/ddspub.hpp>
+#include <dds/sub/ddssub.hpp>
+#include <rti/config/Logger.hpp>  // for logging
+
+#include "temperature.hpp"
+#include "application.hpp"  // Argument parsing
+#include "batch_kernels.hpp"
+
+using namespace application;
+
+const unsigned int DEFAULT_BATCH_SIZE = 1000;
+// Every measurement processes this many samples in total
+const unsigned int SAMPLES_PER_MEASUREMENT = 50000000;
+
+const int32_t THRESHOLD = 31;
+const int32_t HISTOGRAM_FIRST = 20;
+const size_t HISTOGRAM_BUCKETS = 20;
+// Not the ChocolateTemperature topic, so that running subscribers do not
+// receive the benchmark batch
+const std::string TOPIC_NAME = "ChocolateTemperatureBatchBenchmark";
+
+// Time of one measurement, in nanoseconds and in cycles of the time-stamp
+// counter (0 when the CPU has none)
+struct Cost {
+    double ns_per_sample;
+    double cycles_per_sample;
+};
+
+// Runs 'process' on the batch until SAMPLES_PER_MEASUREMENT samples have
+// been processed
+template <typename Process>
+Cost measure(size_t batch_size, Process process)
+{
+    size_t repetitions = std::max<size_t>(
+            1,
+            SAMPLES_PER_MEASUREMENT / std::max<size_t>(1, batch_size));
+    double samples = static_cast<double>(repetitions) * batch_size;
+
+    auto start_time = std::chrono::steady_clock::now();
+#ifdef HAS_CYCLE_COUNTER
+    uint64_t start_cycles = __rdtsc();
+#endif
+    for (size_t i = 0; i < repetitions && running; i++) {
+        process();
+    }
+#ifdef HAS_CYCLE_COUNTER
+    uint64_t cycles = __rdtsc() - start_cycles;
+#else
+    uint64_t cycles = 0;
+#endif
+    std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start_time;
+
+    return { elapsed.count() / samples, cycles / samples };
+}
+
+void print_cost(const char *name, const Cost& cost, const Cost& reference)
+{
+    std::cout << std::setw(20) << name << std::setw(14) << std::fixed
+              << std::setprecision(2) << cost.ns_per_sample << std::setw(16)
+              << cost.cycles_per_sample << std::setw(10)
+              << reference.ns_per_sample / cost.ns_per_sample << "x"
+              << std::endl;
+}
+
+void run_example(unsigned int domain_id, unsigned int batch_size)
+{
+    if (batch_size == 0) {
+        batch_size = DEFAULT_BATCH_SIZE;
+    }
+
+    // The samples are written and read in the same DomainParticipant, so
+    // the benchmark needs no other application
+    dds::domain::DomainParticipant participant(domain_id);
+    dds::topic::Topic<Temperature> topic(participant, TOPIC_NAME);
+    dds::pub::DataWriter<Temperature> writer(
+            dds::pub::Publisher(participant),
+            topic);
+    dds::sub::DataReader<Temperature> reader(
+            dds::sub::Subscriber(participant),
+            topic);
+
+    Temperature sample;
+    sample.sensor_id("benchmark");
+    for (unsigned int i = 0; i < batch_size; i++) {
+        sample.degrees(30 + i % 3);
+        writer.write(sample);
+    }
+
+    // read() leaves the samples in the DataReader: wait until all of them
+    // have been received, then keep the last loan for the measurements
+    dds::sub::LoanedSamples<Temperature> samples;
+    auto deadline =
+            std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (running) {
+        samples = reader.read();
+        if (samples.length() >= batch_size
+            || std::chrono::steady_clock::now() > deadline) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (samples.length() < batch_size) {
+        std::cerr << "Received only " << samples.length() << " of "
+                  << batch_size << " samples" << std::endl;
+        return;
+    }
+
+    // The scalar loop of process_data()
+    std::vector<uint64_t> buckets(HISTOGRAM_BUCKETS);
+    uint64_t above = 0;
+    int64_t total = 0;
+    int32_t min = std::numeric_limits<int32_t>::max();
+    int32_t max = std::numeric_limits<int32_t>::min();
+    Cost scalar = measure(batch_size, [&]() {
+        for (const auto& sample : samples) {
+            if (sample.info().valid()) {
+                int32_t degrees = sample.data().degrees();
+                above += degrees > THRESHOLD;
+                total += degrees;
+                min = std::min(min, degrees);
+                max = std::max(max, degrees);
+                histogram_scalar(
+                        &degrees,
+                        1,
+                        HISTOGRAM_FIRST,
+                        buckets.data(),
+                        buckets.size());
+            }
+        }
+    });
+
+    std::vector<int32_t> degrees;
+    Cost gather = measure(batch_size, [&]() {
+        gather_degrees(samples, degrees);
+    });
+
+    BatchSummary summary(THRESHOLD, HISTOGRAM_FIRST, HISTOGRAM_BUCKETS);
+    Cost batch = measure(batch_size, [&]() { summary.add_samples(samples); });
+
+    Cost kernels = measure(batch_size, [&]() { summary.add(degrees); });
+
+    std::cout << "Batch of " << batch_size << " samples, "
+              << kernel_instruction_set() << " kernels" << std::endl;
+    std::cout << std::setw(20) << "" << std::setw(14) << "ns/sample"
+              << std::setw(16) << "cycles/sample" << std::setw(11)
+              << "speedup" << std::endl;
+    print_cost("scalar", scalar, scalar);
+    print_cost("gather", gather, scalar);
+    print_cost("gather + kernels", batch, scalar);
+    print_cost("kernels", kernels, scalar);
+#ifdef HAS_CYCLE_COUNTER
+    std::cout << "Cycles are time-stamp counter cycles, which run at a fixed "
+                 "frequency"
+              << std::endl;
+#endif
+
+    // Use the results, so the compiler cannot remove the scalar loop
+    if (above + total + min + max + buckets[0] == 0) {
+        std::cout << std::endl;
+    }
+}
+
+// Sets Connext verbosity to help debugging
+void set_verbosity(rti::config::Verbosity verbosity)
+{
+    rti::config::Logger::instance().verbosity(verbosity);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::PARSE_RETURN_EXIT) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::PARSE_RETURN_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Enables different levels of debugging output
+    set_verbosity(arguments.verbosity);
+
+    try {
+        run_example(arguments.domain_id, arguments.sample_count);
+    } catch (const std::exception& ex) {
+        // This will catch DDS exceptions
+        std::cerr << "Exception in benchmark_main(): " << ex.what()
+                  << std::endl;
+        teardown_signal_handlers();
+        return EXIT_FAILURE;
+    }
+
+    teardown_signal_handlers();
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
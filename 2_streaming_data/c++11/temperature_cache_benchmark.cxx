@@ -0,0 +1,276 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+// Measures the last-value cache in last_value_cache.hpp under contention.
+// One writer thread updates --sensors sensors in turn, at --rate updates
+// per second or as fast as possible (the default), like the thread taking
+// the samples in the subscriber. Meanwhile --readers reader threads (16 by
+// default) read random sensors as fast as they can, for --duration
+// seconds. The same load runs against:
+//   - a std::unordered_map protected by a std::mutex, for comparison
+//   - the cache, looking the sensors up by ID
+//   - the cache, reading the sensors by the index resolved beforehand
+// With --sensors 1 (the default), every read contends with every update.
+//
+// Usage: temperature_cache_benchmark [--sensors <n>] [--readers <n>]
+//                                    [-r <updates per second>]
+//                                    [--duration <s>]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <dds/core/ddscore.hpp>
+#include <rti/config/Logger.hpp>  // for logging
+
+#include "application.hpp"  // Argument parsing
+#include "last_value_cache.hpp"
+
+using namespace application;
+
+// The simple alternative: every reader and the writer take the same lock
+class MutexLastValues {
+public:
+    void update(
+            const std::string& sensor_id,
+            int32_t degrees,
+            int64_t source_ns)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        LastValueCache::Reading& reading = readings_[sensor_id];
+        reading.degrees = degrees;
+        reading.source_ns = source_ns;
+        reading.update_count++;
+    }
+
+    bool read(const std::string& sensor_id, LastValueCache::Reading& reading)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = readings_.find(sensor_id);
+        if (found == readings_.end()) {
+            return false;
+        }
+        reading = found->second;
+        return true;
+    }
+
+private:
+    std::mutex mutex_;
+    std::unordered_map<std::string, LastValueCache::Reading> readings_;
+};
+
+struct LoadResult {
+    uint64_t updates;
+    uint64_t reads;
+    uint64_t retries;
+    double seconds;
+};
+
+// Runs the writer and the readers for 'duration'. 'update' is called with
+// the index of a sensor, 'read' with the index of a sensor and returns the
+// number of retries.
+LoadResult run_load(
+        unsigned int sensors,
+        unsigned int reader_threads,
+        double rate,
+        std::chrono::seconds duration,
+        std::function<void(unsigned int)> update,
+        std::function<unsigned int(unsigned int)> read)
+{
+    std::atomic<bool> stop(false);
+    std::vector<uint64_t> reads(reader_threads, 0);
+    std::vector<uint64_t> retries(reader_threads, 0);
+    std::vector<std::thread> readers;
+    for (unsigned int t = 0; t < reader_threads; t++) {
+        readers.push_back(std::thread([&, t]() {
+            std::minstd_rand random_engine(t + 1);
+            std::uniform_int_distribution<unsigned int> sensor(0, sensors - 1);
+            uint64_t thread_reads = 0;
+            uint64_t thread_retries = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                thread_retries += read(sensor(random_engine));
+                thread_reads++;
+            }
+            // Written once, so the counters do not share cache lines
+            // while the readers run
+            reads[t] = thread_reads;
+            retries[t] = thread_retries;
+        }));
+    }
+
+    uint64_t updates = 0;
+    auto start_time = std::chrono::steady_clock::now();
+    auto end_time = start_time + duration;
+    RateScheduler scheduler(rate, OverrunPolicy::CATCH_UP);
+    while (running && std::chrono::steady_clock::now() < end_time) {
+        // Checking the time is slower than an update: do a few at a time
+        for (unsigned int i = 0; i < 64; i++) {
+            scheduler.wait();
+            update(static_cast<unsigned int>(updates % sensors));
+            updates++;
+        }
+    }
+    std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start_time;
+    stop = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    LoadResult result = { updates, 0, 0, elapsed.count() };
+    for (unsigned int t = 0; t < reader_threads; t++) {
+        result.reads += reads[t];
+        result.retries += retries[t];
+    }
+    return result;
+}
+
+void print_result(const char *name, const LoadResult& result)
+{
+    std::cout << std::setw(16) << name << std::setw(14)
+              << result.updates / result.seconds << std::setw(14)
+              << result.reads / result.seconds << std::setw(12)
+              << std::setprecision(3)
+              << (result.reads > 0 ? 100.0 * result.retries / result.reads
+                                   : 0)
+              << std::setprecision(0) << std::endl;
+}
+
+void run_example(
+        unsigned int sensors,
+        unsigned int reader_threads,
+        double rate,
+        unsigned int duration)
+{
+    sensors = std::max(1u, sensors);
+    reader_threads = std::max(1u, reader_threads);
+    std::chrono::seconds seconds(std::max(1u, duration));
+    std::vector<std::string> sensor_ids;
+    for (unsigned int i = 0; i < sensors; i++) {
+        sensor_ids.push_back("sensor_" + std::to_string(i));
+    }
+
+    std::cout << "1 writer";
+    if (rate > 0) {
+        std::cout << " at " << rate << " updates/s";
+    }
+    std::cout << ", " << reader_threads << " readers, " << sensors
+              << " sensors, " << seconds.count() << " s each" << std::endl
+              << std::setw(16) << "" << std::setw(14) << "updates/s"
+              << std::setw(14) << "reads/s" << std::setw(12) << "retries %"
+              << std::endl
+              << std::fixed << std::setprecision(0);
+
+    MutexLastValues mutex_values;
+    for (const auto& sensor_id : sensor_ids) {
+        mutex_values.update(sensor_id, 0, 0);
+    }
+    LoadResult result = run_load(
+            sensors,
+            reader_threads,
+            rate,
+            seconds,
+            [&](unsigned int sensor) {
+                mutex_values.update(sensor_ids[sensor], sensor, sensor);
+            },
+            [&](unsigned int sensor) -> unsigned int {
+                LastValueCache::Reading reading;
+                mutex_values.read(sensor_ids[sensor], reading);
+                return 0;
+            });
+    print_result("mutex map", result);
+
+    // The sensors are added before the readers start, as in a running
+    // subscriber
+    LastValueCache cache(sensors);
+    for (const auto& sensor_id : sensor_ids) {
+        cache.update(sensor_id, 0, 0);
+    }
+    auto update_cache = [&](unsigned int sensor) {
+        cache.update(sensor_ids[sensor], sensor, sensor);
+    };
+    result = run_load(
+            sensors,
+            reader_threads,
+            rate,
+            seconds,
+            update_cache,
+            [&](unsigned int sensor) -> unsigned int {
+                size_t index = cache.find(sensor_ids[sensor]);
+                LastValueCache::Reading reading;
+                return cache.read(index, reading);
+            });
+    print_result("cache by ID", result);
+
+    std::vector<size_t> indexes;
+    for (const auto& sensor_id : sensor_ids) {
+        indexes.push_back(cache.find(sensor_id));
+    }
+    result = run_load(
+            sensors,
+            reader_threads,
+            rate,
+            seconds,
+            update_cache,
+            [&](unsigned int sensor) -> unsigned int {
+                LastValueCache::Reading reading;
+                return cache.read(indexes[sensor], reading);
+            });
+    print_result("cache by index", result);
+}
+
+// Sets Connext verbosity to help debugging
+void set_verbosity(rti::config::Verbosity verbosity)
+{
+    rti::config::Logger::instance().verbosity(verbosity);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::PARSE_RETURN_EXIT) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::PARSE_RETURN_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Enables different levels of debugging output
+    set_verbosity(arguments.verbosity);
+
+    try {
+        run_example(
+                arguments.sensors,
+                arguments.readers,
+                arguments.rate,
+                arguments.duration);
+    } catch (const std::exception& ex) {
+        std::cerr << "Exception in benchmark_main(): " << ex.what()
+                  << std::endl;
+        teardown_signal_handlers();
+        return EXIT_FAILURE;
+    }
+
+    teardown_signal_handlers();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,272 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+// Measures the compression ratio and the encoding and decoding speed of the
+// time-series codec in time_series_codec.hpp, used by the subscriber's
+// --history. The readings are either:
+//   - recorded with temperature_subscriber --record (--replay <dir>): the
+//     source timestamp and degrees of every sample, per sensor. This is the
+//     ratio to expect on real data.
+//   - generated: --sensors sensors, each reading every 1/--rate seconds
+//     with up to SYNTHETIC_JITTER_NS of jitter, and changing by one degree
+//     in one reading out of SYNTHETIC_CHANGE_PERIOD.
+// Each measurement is repeated with timestamps kept to the nanosecond
+// (lossless), to the microsecond (as in the history) and to the millisecond.
+//
+// Usage: temperature_codec_benchmark [--replay <dir>] [--sensors <n>]
+//                                    [-r <Hz>] [-s <readings per sensor>]
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <dds/core/ddscore.hpp>
+#include <rti/config/Logger.hpp>  // for logging
+
+#include "temperature.hpp"
+#include "application.hpp"  // Argument parsing
+#include "sample_log.hpp"
+#include "time_series_codec.hpp"
+
+using namespace application;
+
+const unsigned int DEFAULT_READINGS_PER_SENSOR = 100000;
+const double DEFAULT_RATE = 100;
+const int64_t SYNTHETIC_JITTER_NS = 2000;
+const unsigned int SYNTHETIC_CHANGE_PERIOD = 10;
+// Every measurement encodes or decodes at least this many readings
+const uint64_t READINGS_PER_MEASUREMENT = 20000000;
+
+volatile uint64_t decoded_checksum;
+
+struct Reading {
+    int64_t timestamp;
+    int32_t degrees;
+};
+
+typedef std::vector<std::vector<Reading>> SensorReadings;
+
+SensorReadings read_log(const std::string& directory)
+{
+    SampleLogReader log(directory);
+    SampleLogReader::Record record;
+    Temperature sample;
+    std::unordered_map<std::string, size_t> sensor_indexes;
+    SensorReadings readings;
+    while (running && log.next(record)) {
+        log.read_sample(record, sample);
+        auto inserted = sensor_indexes.insert(
+                std::make_pair(sample.sensor_id(), readings.size()));
+        if (inserted.second) {
+            readings.emplace_back();
+        }
+        Reading reading = { record.header->source_ns, sample.degrees() };
+        readings[inserted.first->second].push_back(reading);
+    }
+    return readings;
+}
+
+SensorReadings generate_readings(
+        unsigned int sensors,
+        unsigned int readings_per_sensor,
+        double rate)
+{
+    std::minstd_rand random_engine(42);
+    std::uniform_int_distribution<int64_t> jitter(
+            -SYNTHETIC_JITTER_NS / 2,
+            SYNTHETIC_JITTER_NS / 2);
+    std::uniform_int_distribution<unsigned int> change(
+            0,
+            2 * SYNTHETIC_CHANGE_PERIOD - 1);
+    int64_t period_ns = static_cast<int64_t>(1e9 / rate);
+    int64_t start_ns = 1600000000LL * 1000000000LL;
+
+    SensorReadings readings(sensors);
+    for (auto& sensor : readings) {
+        int32_t degrees = 30;
+        sensor.reserve(readings_per_sensor);
+        for (unsigned int i = 0; i < readings_per_sensor; i++) {
+            unsigned int step = change(random_engine);
+            if (step == 0) {
+                degrees++;
+            } else if (step == 1) {
+                degrees--;
+            }
+            Reading reading = {
+                start_ns + i * period_ns + jitter(random_engine),
+                degrees
+            };
+            sensor.push_back(reading);
+        }
+    }
+    return readings;
+}
+
+// Repeats 'process' until READINGS_PER_MEASUREMENT readings have been
+// processed, and returns the nanoseconds per reading
+template <typename Process>
+double measure(uint64_t readings, Process process)
+{
+    uint64_t repetitions = std::max<uint64_t>(
+            1,
+            READINGS_PER_MEASUREMENT / std::max<uint64_t>(1, readings));
+    auto start_time = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < repetitions && running; i++) {
+        process();
+    }
+    std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start_time;
+    return elapsed.count() / (static_cast<double>(repetitions) * readings);
+}
+
+// Encodes and decodes all the readings with timestamps rounded to
+// 'resolution_ns', and prints a row of results. Returns false if a reading
+// does not decode to what was encoded.
+bool measure_resolution(
+        const SensorReadings& readings,
+        uint64_t count,
+        const char *name,
+        int64_t resolution_ns)
+{
+    std::vector<CompressedSeries> series;
+    double encode_ns = measure(count, [&]() {
+        series.assign(readings.size(), CompressedSeries(resolution_ns));
+        for (size_t i = 0; i < readings.size(); i++) {
+            for (const Reading& reading : readings[i]) {
+                series[i].append(reading.timestamp, reading.degrees);
+            }
+        }
+    });
+
+    uint64_t checksum = 0;
+    double decode_ns = measure(count, [&]() {
+        for (const auto& sensor_series : series) {
+            CompressedSeries::Reader reader(sensor_series);
+            int64_t timestamp;
+            int32_t degrees;
+            while (reader.next(timestamp, degrees)) {
+                checksum += static_cast<uint64_t>(timestamp) + degrees;
+            }
+        }
+    });
+
+    for (size_t i = 0; i < readings.size(); i++) {
+        CompressedSeries::Reader reader(series[i]);
+        for (const Reading& reading : readings[i]) {
+            int64_t rounded = reading.timestamp
+                    - (reading.timestamp % resolution_ns + resolution_ns)
+                            % resolution_ns;
+            int64_t timestamp;
+            int32_t degrees;
+            if (!reader.next(timestamp, degrees) || timestamp != rounded
+                || degrees != reading.degrees) {
+                std::cerr << "Decoding error in sensor " << i << std::endl;
+                return false;
+            }
+        }
+    }
+
+    size_t compressed = 0;
+    for (const auto& sensor_series : series) {
+        compressed += sensor_series.compressed_size();
+    }
+    size_t raw = CompressedSeries::raw_size(count);
+    std::cout << std::setw(12) << name << std::setw(14) << compressed
+              << std::setw(10) << static_cast<double>(raw) / compressed
+              << std::setw(10) << 8.0 * compressed / count << std::setw(12)
+              << encode_ns << std::setw(12) << decode_ns << std::endl;
+
+    // Use the results, so the compiler cannot remove the decoding loop
+    decoded_checksum = checksum;
+    return true;
+}
+
+void run_example(
+        const std::string& replay_directory,
+        unsigned int sensors,
+        unsigned int readings_per_sensor,
+        double rate)
+{
+    SensorReadings readings = replay_directory.empty()
+            ? generate_readings(
+                    std::max(1u, sensors),
+                    readings_per_sensor > 0 ? readings_per_sensor
+                                            : DEFAULT_READINGS_PER_SENSOR,
+                    rate > 0 ? rate : DEFAULT_RATE)
+            : read_log(replay_directory);
+    uint64_t count = 0;
+    for (const auto& sensor : readings) {
+        count += sensor.size();
+    }
+    if (count == 0) {
+        std::cout << "No readings" << std::endl;
+        return;
+    }
+
+    std::cout << (replay_directory.empty() ? "Generated " : "Recorded ")
+              << count << " readings of " << readings.size() << " sensors, "
+              << CompressedSeries::raw_size(count) << " bytes uncompressed"
+              << std::endl
+              << std::setw(12) << "resolution" << std::setw(14) << "bytes"
+              << std::setw(10) << "ratio" << std::setw(10) << "bits"
+              << std::setw(12) << "encode ns" << std::setw(12) << "decode ns"
+              << std::endl
+              << std::fixed << std::setprecision(2);
+    // 1 ns is lossless; the subscriber's history keeps microseconds
+    measure_resolution(readings, count, "1 ns", 1)
+            && measure_resolution(readings, count, "1 us", 1000)
+            && measure_resolution(readings, count, "1 ms", 1000000);
+    std::cout << "bits and ns are per reading" << std::endl;
+}
+
+// Sets Connext verbosity to help debugging
+void set_verbosity(rti::config::Verbosity verbosity)
+{
+    rti::config::Logger::instance().verbosity(verbosity);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::PARSE_RETURN_EXIT) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::PARSE_RETURN_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Enables different levels of debugging output
+    set_verbosity(arguments.verbosity);
+
+    try {
+        run_example(
+                arguments.replay_directory,
+                arguments.sensors,
+                arguments.sample_count,
+                arguments.rate);
+    } catch (const std::exception& ex) {
+        std::cerr << "Exception in benchmark_main(): " << ex.what()
+                  << std::endl;
+        teardown_signal_handlers();
+        return EXIT_FAILURE;
+    }
+
+    teardown_signal_handlers();
+
+    return EXIT_SUCCESS;
+}
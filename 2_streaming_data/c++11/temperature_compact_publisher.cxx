@@ -0,0 +1,186 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include <dds/pub/ddspub.hpp>
+#include <rti/config/Logger.hpp>  // for logging
+// Or simply include <dds/dds.hpp>
+
+#include "temperature_compact.hpp"
+#include "application.hpp"  // Argument parsing
+
+using namespace application;
+
+// Nanoseconds since the Unix epoch
+int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+}
+
+void run_example(
+        unsigned int domain_id,
+        unsigned int sample_count,
+        const std::string& sensor_id,
+        double rate,
+        OverrunPolicy overrun_policy,
+        unsigned int spin_us,
+        unsigned int sensors)
+{
+    // By default write one sample every 4 seconds
+    if (rate == 0) {
+        rate = 0.25;
+    }
+    sensors = std::max(1u, sensors);
+    // Printing every write would limit the rate more than DDS does
+    bool print_writes = rate * sensors <= 10;
+
+    // DomainParticipant QoS is configured in USER_QOS_PROFILES.xml
+    dds::domain::DomainParticipant participant(domain_id);
+    dds::pub::Publisher publisher(participant);
+
+    // Publish the name of every sensor once on the "ChocolateSensorNames"
+    // Topic. The DataWriter keeps the names for subscribers that start
+    // later, so the names never need to be sent with each temperature
+    dds::topic::Topic<SensorName> directory_topic(
+            participant,
+            "ChocolateSensorNames");
+    dds::pub::DataWriter<SensorName> directory_writer(
+            publisher,
+            directory_topic,
+            dds::core::QosProvider::Default().datawriter_qos(
+                    "ChocolateFactoryLibrary::SensorDirectoryProfile"));
+    for (uint32_t id = 0; id < sensors; id++) {
+        std::string name = sensor_id;
+        if (sensors > 1) {
+            name = (sensor_id.empty() ? "sensor" : sensor_id) + "_"
+                    + std::to_string(id);
+        }
+        directory_writer.write(SensorName(id, name));
+    }
+
+    // A Topic has a name and a datatype. Create a Topic named
+    // "ChocolateTemperatureCompact" with type TemperatureCompact
+    dds::topic::Topic<TemperatureCompact> topic(
+            participant,
+            "ChocolateTemperatureCompact");
+
+    // This DataWriter writes data on Topic "ChocolateTemperatureCompact"
+    // DataWriter QoS is configured in USER_QOS_PROFILES.xml
+    dds::pub::DataWriter<TemperatureCompact> writer(publisher, topic);
+
+    std::minstd_rand random_engine(std::random_device {}());
+    std::uniform_int_distribution<int32_t> random_degrees(30, 32);
+
+    // Exercise: Change the rate to write one temperature every 10 ms
+    RateScheduler scheduler(
+            rate * sensors,
+            overrun_policy,
+            std::chrono::microseconds(spin_us));
+    auto start_time = std::chrono::steady_clock::now();
+    uint64_t total_count = static_cast<uint64_t>(sample_count) * sensors;
+    uint64_t count = 0;
+    uint32_t next_sensor = 0;
+    for (; running && (count < total_count || sample_count == 0); count++) {
+        if (!scheduler.wait()) {
+            break;  // Control-C
+        }
+
+        // FlatData samples are not created by the application: they are
+        // loaned from the DataWriter, filled in place and returned to it by
+        // write(). There is no serialization step.
+        TemperatureCompact *sample = writer.extensions().get_loan();
+        TemperatureCompactOffset root = sample->root();
+        root.sensor_id(next_sensor);
+        root.timestamp(now_ns());
+        root.degrees(random_degrees(random_engine));
+
+        if (print_writes) {
+            console.print("Writing ChocolateTemperatureCompact, count ", count);
+        }
+
+        writer.write(*sample);
+
+        if (++next_sensor == sensors) {
+            next_sensor = 0;
+        }
+    }
+    scheduler.stop();
+    // The rate below only counts the time spent writing, not the time
+    // spent waiting for the DataReaders to acknowledge the last samples
+    auto end_time = std::chrono::steady_clock::now();
+    wait_for_acknowledgments_on_exit(writer);
+
+    std::chrono::duration<double> elapsed = end_time - start_time;
+    std::chrono::duration<double> drain_time =
+            std::chrono::steady_clock::now() - end_time;
+    console.stop();  // Print the queued lines before the summary
+    std::cout << "Wrote " << count << " samples from " << sensors
+              << " sensors in " << elapsed.count() << " s ("
+              << (elapsed.count() > 0 ? count / elapsed.count() : 0)
+              << " msgs/s), then " << drain_time.count()
+              << " s sending the last samples" << std::endl;
+    scheduler.print_report(std::cout);
+}
+
+// Sets Connext verbosity to help debugging
+void set_verbosity(rti::config::Verbosity verbosity)
+{
+    rti::config::Logger::instance().verbosity(verbosity);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::PARSE_RETURN_EXIT) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::PARSE_RETURN_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Enables different levels of debugging output
+    set_verbosity(arguments.verbosity);
+    console.start(arguments.output_mode);
+
+    try {
+        run_example(
+                arguments.domain_id,
+                arguments.sample_count,
+                arguments.sensor_id,
+                arguments.rate,
+                arguments.overrun_policy,
+                arguments.spin_us,
+                arguments.sensors);
+    } catch (const std::exception& ex) {
+        // This will catch DDS exceptions
+        std::cerr << "Exception in publisher_main(): " << ex.what()
+                  << std::endl;
+        teardown_signal_handlers();
+        return EXIT_FAILURE;
+    }
+
+    teardown_signal_handlers();
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
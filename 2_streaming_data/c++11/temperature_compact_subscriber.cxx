@@ -0,0 +1,175 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+#include <dds/sub/ddssub.hpp>
+#include <dds/core/ddscore.hpp>
+#include <rti/config/Logger.hpp>  // for logging
+// Or simply include <dds/dds.hpp>
+
+#include "temperature_compact.hpp"
+#include "application.hpp"  // Argument parsing
+
+using namespace application;
+
+// Sensor names by numeric sensor ID
+typedef std::unordered_map<uint32_t, std::string> SensorDirectory;
+
+// Updates the sensor directory with the names received
+void process_directory(
+        dds::sub::DataReader<SensorName>& reader,
+        SensorDirectory& directory)
+{
+    dds::sub::LoanedSamples<SensorName> samples = reader.take();
+    for (const auto& sample : samples) {
+        if (sample.info().valid()) {
+            directory[sample.data().sensor_id()] = sample.data().name();
+        }
+    }
+}
+
+unsigned int process_data(
+        dds::sub::DataReader<TemperatureCompact>& reader,
+        const SensorDirectory& directory)
+{
+    // Take all samples.  Samples are loaned to application, loan is
+    // returned when LoanedSamples destructor called.
+    unsigned int samples_read = 0;
+    dds::sub::LoanedSamples<TemperatureCompact> samples = reader.take();
+    for (const auto& sample : samples) {
+        if (sample.info().valid()) {
+            samples_read++;
+
+            // FlatData samples are read in place, through an Offset to
+            // the root of the sample
+            auto root = sample.data().root();
+            auto name = directory.find(root.sensor_id());
+            // Print the numeric ID if the name has not been received yet
+            console.print(
+                    "[sensor_id: ",
+                    name != directory.end() ? name->second
+                                            : std::to_string(root.sensor_id()),
+                    ", timestamp: ",
+                    root.timestamp(),
+                    ", degrees: ",
+                    root.degrees(),
+                    "]");
+        }
+    }
+
+    return samples_read;
+}  // The LoanedSamples destructor returns the loan
+
+void run_example(unsigned int domain_id, unsigned int sample_count)
+{
+    // DomainParticipant QoS is configured in USER_QOS_PROFILES.xml
+    dds::domain::DomainParticipant participant(domain_id);
+    dds::sub::Subscriber subscriber(participant);
+
+    // This DataReader receives the sensor names, including the ones
+    // published before this application started
+    dds::topic::Topic<SensorName> directory_topic(
+            participant,
+            "ChocolateSensorNames");
+    dds::sub::DataReader<SensorName> directory_reader(
+            subscriber,
+            directory_topic,
+            dds::core::QosProvider::Default().datareader_qos(
+                    "ChocolateFactoryLibrary::SensorDirectoryProfile"));
+
+    // This DataReader reads data of type TemperatureCompact on Topic
+    // "ChocolateTemperatureCompact". DataReader QoS is configured in
+    // USER_QOS_PROFILES.xml
+    dds::topic::Topic<TemperatureCompact> topic(
+            participant,
+            "ChocolateTemperatureCompact");
+    dds::sub::DataReader<TemperatureCompact> reader(subscriber, topic);
+
+    // Process each DataReader's data when its 'data available' status
+    // becomes true, in the context of the dispatch call (see below)
+    SensorDirectory directory;
+    dds::core::cond::StatusCondition directory_condition(directory_reader);
+    directory_condition.enabled_statuses(
+            dds::core::status::StatusMask::data_available());
+    directory_condition.extensions().handler(
+            [&directory_reader, &directory]() {
+                process_directory(directory_reader, directory);
+            });
+
+    unsigned int samples_read = 0;
+    dds::core::cond::StatusCondition status_condition(reader);
+    status_condition.enabled_statuses(
+            dds::core::status::StatusMask::data_available());
+    status_condition.extensions().handler(
+            [&reader, &directory, &samples_read]() {
+                samples_read += process_data(reader, directory);
+            });
+
+    // Create a WaitSet and attach both StatusConditions
+    dds::core::cond::WaitSet waitset;
+    waitset += directory_condition;
+    waitset += status_condition;
+    waitset += shutdown_condition();  // Wakes it up on control-C
+
+    while (running && (samples_read < sample_count || sample_count == 0)) {
+        // Dispatch will call the handlers associated to the WaitSet conditions
+        // when they activate
+        console.print(
+                "ChocolateTemperatureCompact subscriber sleeping for 4 sec...");
+
+        waitset.dispatch(dds::core::Duration(4));  // Wait up to 4s each time
+    }
+    console.stop();
+}
+
+// Sets Connext verbosity to help debugging
+void set_verbosity(rti::config::Verbosity verbosity)
+{
+    rti::config::Logger::instance().verbosity(verbosity);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::PARSE_RETURN_EXIT) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::PARSE_RETURN_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Enables different levels of debugging output
+    set_verbosity(arguments.verbosity);
+    console.start(arguments.output_mode);
+
+    try {
+        run_example(arguments.domain_id, arguments.sample_count);
+    } catch (const std::exception& ex) {
+        // All DDS exceptions inherit from std::exception
+        std::cerr << "Exception in subscriber_main(): " << ex.what()
+                  << std::endl;
+        teardown_signal_handlers();
+        return EXIT_FAILURE;
+    }
+
+    teardown_signal_handlers();
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
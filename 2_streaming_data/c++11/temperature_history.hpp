@@ -0,0 +1,151 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef TEMPERATURE_HISTORY_HPP
+#define TEMPERATURE_HISTORY_HPP
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+#include "time_series_codec.hpp"
+
+namespace application {
+
+// The readings of every sensor over the last 'retention' nanoseconds, kept
+// compressed in memory. The readings of a sensor are stored in chunks of
+// up to SAMPLES_PER_CHUNK; a chunk is dropped as a whole once its last
+// reading is older than the retention. add() drops the old chunks of the
+// sensor it adds to, and expire() those of every sensor, including the
+// sensors that stopped sending, so that when expire() is called regularly
+// the history holds at least the retention period and at most one chunk
+// plus one sweep period more per sensor. Timestamps are kept to the
+// microsecond, which is enough for display and lets readings that are
+// a few microseconds early or late compress almost as well as evenly
+// spaced ones. Not thread-safe.
+class TemperatureHistory {
+public:
+    static const uint64_t SAMPLES_PER_CHUNK = 4096;
+    static const int64_t TIMESTAMP_RESOLUTION_NS = 1000;
+    static const int64_t SWEEP_PERIOD_NS = 1000000000;
+
+    explicit TemperatureHistory(int64_t retention_ns)
+            : retention_ns_(retention_ns), next_sweep_ns_(0)
+    {
+    }
+
+    void add(const std::string& sensor_id, int64_t timestamp, int32_t degrees)
+    {
+        std::deque<CompressedSeries>& chunks = sensors_[sensor_id];
+        if (chunks.empty() || chunks.back().size() == SAMPLES_PER_CHUNK) {
+            if (!chunks.empty()) {
+                chunks.back().seal();
+            }
+            chunks.push_back(CompressedSeries(TIMESTAMP_RESOLUTION_NS));
+        }
+        chunks.back().append(timestamp, degrees);
+
+        while (chunks.size() > 1
+               && chunks.front().last_timestamp() < timestamp - retention_ns_) {
+            chunks.pop_front();
+        }
+    }
+
+    // Drops the chunks of every sensor whose last reading is older than the
+    // retention at 'now_ns', from the same clock as the timestamps, and the
+    // sensors left without readings. Goes over all the sensors at most once
+    // per SWEEP_PERIOD_NS, so it can be called after every batch of samples.
+    void expire(int64_t now_ns)
+    {
+        if (now_ns < next_sweep_ns_) {
+            return;
+        }
+        next_sweep_ns_ = now_ns + SWEEP_PERIOD_NS;
+
+        for (auto sensor = sensors_.begin(); sensor != sensors_.end();) {
+            std::deque<CompressedSeries>& chunks = sensor->second;
+            while (!chunks.empty()
+                   && chunks.front().last_timestamp()
+                           < now_ns - retention_ns_) {
+                chunks.pop_front();
+            }
+            if (chunks.empty()) {
+                sensor = sensors_.erase(sensor);
+            } else {
+                ++sensor;
+            }
+        }
+    }
+
+    // Calls 'reader' with every reading of a sensor still in the history
+    // from 'since_ns' on, oldest first. The chunks that end before it are
+    // skipped without decoding them.
+    void read(
+            const std::string& sensor_id,
+            int64_t since_ns,
+            std::function<void(int64_t, int32_t)> reader) const
+    {
+        auto found = sensors_.find(sensor_id);
+        if (found == sensors_.end()) {
+            return;
+        }
+        for (const auto& chunk : found->second) {
+            if (chunk.last_timestamp() < since_ns) {
+                continue;
+            }
+            CompressedSeries::Reader chunk_reader(chunk);
+            int64_t timestamp;
+            int32_t degrees;
+            while (chunk_reader.next(timestamp, degrees)) {
+                if (timestamp >= since_ns) {
+                    reader(timestamp, degrees);
+                }
+            }
+        }
+    }
+
+    // Prints the readings kept and the memory they use, compared with the
+    // same readings uncompressed
+    void print_summary(std::ostream& out) const
+    {
+        uint64_t samples = 0;
+        size_t compressed = 0;
+        size_t allocated = 0;
+        for (const auto& sensor : sensors_) {
+            for (const auto& chunk : sensor.second) {
+                samples += chunk.size();
+                compressed += chunk.compressed_size();
+                allocated += chunk.memory_size();
+            }
+        }
+        size_t raw = CompressedSeries::raw_size(samples);
+        out << "History: " << samples << " readings of " << sensors_.size()
+            << " sensors, " << compressed << " bytes compressed ("
+            << allocated << " allocated), " << raw << " bytes uncompressed";
+        if (compressed > 0) {
+            out << ", ratio " << static_cast<double>(raw) / compressed;
+        }
+        out << std::endl;
+    }
+
+private:
+    int64_t retention_ns_;
+    int64_t next_sweep_ns_;
+    std::unordered_map<std::string, std::deque<CompressedSeries>> sensors_;
+};
+
+}  // namespace application
+
+#endif  // TEMPERATURE_HISTORY_HPP
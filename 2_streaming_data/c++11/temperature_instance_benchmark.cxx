@@ -0,0 +1,168 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+// Measures the cost of writing keyed Temperature samples with a cached
+// InstanceHandle (returned by register_instance) compared to writing with a
+// nil handle, which makes the DataWriter hash the sensor_id key and look up
+// the instance on every write. The test is repeated for 1 to 1,000,000
+// instances (sensors).
+//
+// Usage: temperature_instance_benchmark [-d <domain>] [-s <writes>]
+//   -s is the number of writes timed for each instance count.
+//      Default: 1,000,000
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <dds/pub/ddspub.hpp>
+#include <rti/config/Logger.hpp>  // for logging
+
+#include "temperature.hpp"
+#include "application.hpp"  // Argument parsing
+
+using namespace application;
+
+const unsigned int DEFAULT_WRITE_COUNT = 1000000;
+const unsigned int MAX_INSTANCE_COUNT = 1000000;
+// Not the ChocolateTemperature topic, so that running subscribers do not
+// receive up to a million benchmark sensors
+const std::string TOPIC_NAME = "ChocolateTemperatureInstanceBenchmark";
+
+// Returns the average time of one write in nanoseconds. The writes go
+// round-robin over the samples. When instance_handles is empty, every write
+// uses a nil handle. Control-C can end the writes early: the average is
+// over the writes done.
+double time_writes(
+        dds::pub::DataWriter<Temperature>& writer,
+        std::vector<Temperature>& samples,
+        const std::vector<dds::core::InstanceHandle>& instance_handles,
+        unsigned int write_count)
+{
+    dds::core::InstanceHandle nil_handle = dds::core::InstanceHandle::nil();
+    size_t next_sample = 0;
+    unsigned int writes_done = 0;
+
+    auto start_time = std::chrono::steady_clock::now();
+    for (; writes_done < write_count && running; writes_done++) {
+        Temperature& sample = samples[next_sample];
+        sample.degrees(30 + writes_done % 3);
+        writer.write(
+                sample,
+                instance_handles.empty() ? nil_handle
+                                         : instance_handles[next_sample]);
+        if (++next_sample == samples.size()) {
+            next_sample = 0;
+        }
+    }
+    std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start_time;
+
+    return writes_done > 0 ? elapsed.count() / writes_done : 0;
+}
+
+void run_example(unsigned int domain_id, unsigned int write_count)
+{
+    if (write_count == 0) {
+        write_count = DEFAULT_WRITE_COUNT;
+    }
+
+    // DomainParticipant QoS is configured in USER_QOS_PROFILES.xml
+    dds::domain::DomainParticipant participant(domain_id);
+    dds::topic::Topic<Temperature> topic(participant, TOPIC_NAME);
+    dds::pub::Publisher publisher(participant);
+
+    // Keep only the last sample of each instance, so the writer queue does
+    // not grow with the number of writes when there is no reader
+    dds::pub::qos::DataWriterQos writer_qos =
+            dds::core::QosProvider::Default().datawriter_qos();
+    writer_qos << dds::core::policy::History::KeepLast(1);
+
+    std::cout << std::setw(10) << "instances" << std::setw(16)
+              << "register (ns)" << std::setw(16) << "cached (ns)"
+              << std::setw(16) << "nil (ns)" << std::endl;
+
+    for (unsigned int instance_count = 1;
+         running && instance_count <= MAX_INSTANCE_COUNT;
+         instance_count *= 10) {
+        // A new DataWriter for each instance count, so earlier runs do not
+        // leave instances behind
+        dds::pub::DataWriter<Temperature> writer(publisher, topic, writer_qos);
+
+        std::vector<Temperature> samples(instance_count);
+        std::vector<dds::core::InstanceHandle> instance_handles;
+        instance_handles.reserve(instance_count);
+
+        auto start_time = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < instance_count; i++) {
+            samples[i].sensor_id("sensor_" + std::to_string(i));
+            instance_handles.push_back(writer.register_instance(samples[i]));
+        }
+        std::chrono::duration<double, std::nano> register_time =
+                std::chrono::steady_clock::now() - start_time;
+
+        double cached_ns =
+                time_writes(writer, samples, instance_handles, write_count);
+        double nil_ns = time_writes(
+                writer,
+                samples,
+                std::vector<dds::core::InstanceHandle>(),
+                write_count);
+
+        std::cout << std::setw(10) << instance_count << std::setw(16)
+                  << register_time.count() / instance_count << std::setw(16)
+                  << cached_ns << std::setw(16) << nil_ns << std::endl;
+
+        writer.close();
+    }
+}
+
+// Sets Connext verbosity to help debugging
+void set_verbosity(rti::config::Verbosity verbosity)
+{
+    rti::config::Logger::instance().verbosity(verbosity);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::PARSE_RETURN_EXIT) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::PARSE_RETURN_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Enables different levels of debugging output
+    set_verbosity(arguments.verbosity);
+
+    try {
+        run_example(arguments.domain_id, arguments.sample_count);
+    } catch (const std::exception& ex) {
+        // This will catch DDS exceptions
+        std::cerr << "Exception in benchmark_main(): " << ex.what()
+                  << std::endl;
+        teardown_signal_handlers();
+        return EXIT_FAILURE;
+    }
+
+    teardown_signal_handlers();
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,315 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+// Measures the QoS profiles of USER_QOS_PROFILES.xml on this machine, so
+// that operators can choose one per deployment. For each profile, a
+// DataWriter and a DataReader in two DomainParticipants of this process
+// exchange Temperature samples, and the benchmark measures:
+//   - latency: -s samples written one at a time, each one from write() until
+//     the DataReader takes it
+//   - throughput: samples written as fast as the profile allows for
+//     --duration seconds, and the samples per second the DataReader receives
+//     from them. A KEEP_LAST profile can replace samples the DataReader has
+//     not received yet: those are counted as lost.
+// By default every profile is measured in turn; --qos-profile measures only
+// one. LowLatencyRealtimeTemperatureProfile needs privileges: without them
+// it is skipped.
+//
+// Usage: temperature_profile_benchmark [-d <domain>] [-s <samples>]
+//                                      [--duration <s>]
+//                                      [--qos-profile <profile>]
+//   -s is the number of samples timed for the latency. Default: 1000
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dds/pub/ddspub.hpp>
+#include <dds/sub/ddssub.hpp>
+#include <rti/config/Logger.hpp>  // for logging
+
+#include "temperature.hpp"
+#include "application.hpp"  // Argument parsing
+#include "hdr_histogram.hpp"
+
+using namespace application;
+
+const std::vector<std::string> DEFAULT_PROFILES = {
+    "ChocolateFactoryLibrary::TemperingTemperatureProfile",
+    "ChocolateFactoryLibrary::LowLatencyTemperatureProfile",
+    "ChocolateFactoryLibrary::LowLatencyRealtimeTemperatureProfile",
+    "ChocolateFactoryLibrary::HighThroughputTemperatureProfile"
+};
+const unsigned int DEFAULT_LATENCY_SAMPLES = 1000;
+const std::chrono::milliseconds DISCOVERY_TIMEOUT(10000);
+const dds::core::Duration SAMPLE_TIMEOUT(1);
+const dds::core::Duration DRAIN_TIMEOUT(10);
+
+// The DomainParticipants, DataWriter and DataReader of one profile
+struct ProfileEntities {
+    ProfileEntities(unsigned int domain_id, const std::string& profile)
+            : qos_provider(dds::core::QosProvider::Default()),
+              writer_participant(
+                      domain_id,
+                      qos_provider.participant_qos(profile)),
+              reader_participant(
+                      domain_id,
+                      qos_provider.participant_qos(profile)),
+              writer(dds::pub::Publisher(writer_participant),
+                     dds::topic::Topic<Temperature>(
+                             writer_participant,
+                             "ChocolateTemperatureProfileBenchmark"),
+                     qos_provider.datawriter_qos(profile)),
+              reader(dds::sub::Subscriber(reader_participant),
+                     dds::topic::Topic<Temperature>(
+                             reader_participant,
+                             "ChocolateTemperatureProfileBenchmark"),
+                     qos_provider.datareader_qos(profile)),
+              data_available(reader)
+    {
+        data_available.enabled_statuses(
+                dds::core::status::StatusMask::data_available());
+        waitset += data_available;
+    }
+
+    dds::core::QosProvider qos_provider;
+    dds::domain::DomainParticipant writer_participant;
+    dds::domain::DomainParticipant reader_participant;
+    dds::pub::DataWriter<Temperature> writer;
+    dds::sub::DataReader<Temperature> reader;
+    dds::core::cond::StatusCondition data_available;
+    dds::core::cond::WaitSet waitset;
+};
+
+struct ProfileResults {
+    HdrHistogram latency;  // ns
+    uint64_t written;
+    uint64_t received;
+    double write_seconds;  // Until the last write
+    double receive_seconds;  // Until the DataReader received what is left
+};
+
+void wait_for_match(ProfileEntities& entities)
+{
+    auto end_time = std::chrono::steady_clock::now() + DISCOVERY_TIMEOUT;
+    while (entities.reader.subscription_matched_status().current_count() == 0
+           || entities.writer.publication_matched_status().current_count()
+                   == 0) {
+        if (!running || std::chrono::steady_clock::now() >= end_time) {
+            throw std::runtime_error("The DataReader was not discovered");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// Writes one sample at a time and waits until the DataReader takes it
+void measure_latency(
+        ProfileEntities& entities,
+        unsigned int sample_count,
+        HdrHistogram& latency)
+{
+    Temperature sample;
+    sample.sensor_id("profile_benchmark");
+    for (unsigned int i = 0; running && i < sample_count; i++) {
+        sample.degrees(static_cast<int32_t>(i));
+        auto write_time = std::chrono::steady_clock::now();
+        entities.writer.write(sample);
+
+        bool received = false;
+        while (running && !received) {
+            if (entities.waitset.wait(SAMPLE_TIMEOUT).empty()) {
+                throw std::runtime_error("A latency sample was not received");
+            }
+            dds::sub::LoanedSamples<Temperature> taken =
+                    entities.reader.take();
+            for (const auto& taken_sample : taken) {
+                if (taken_sample.info().valid()
+                    && taken_sample.data().degrees()
+                            == static_cast<int32_t>(i)) {
+                    received = true;
+                }
+            }
+        }
+        if (!received) {
+            break;
+        }
+        std::chrono::duration<double, std::nano> elapsed =
+                std::chrono::steady_clock::now() - write_time;
+        latency.record(static_cast<uint64_t>(elapsed.count()));
+    }
+}
+
+// Writes from another thread for 'duration', while this one takes what
+// arrives
+void measure_throughput(
+        ProfileEntities& entities,
+        std::chrono::seconds duration,
+        ProfileResults& results)
+{
+    std::atomic<bool> writing(true);
+    uint64_t written = 0;
+    auto start_time = std::chrono::steady_clock::now();
+    auto write_end_time = start_time;
+    std::thread writer_thread([&entities, &writing, &written, &write_end_time,
+                               start_time, duration]() {
+        Temperature sample;
+        sample.sensor_id("profile_benchmark");
+        auto end_time = start_time + duration;
+        while (running && std::chrono::steady_clock::now() < end_time) {
+            sample.degrees(static_cast<int32_t>(written % 100));
+            entities.writer.write(sample);
+            written++;
+        }
+        write_end_time = std::chrono::steady_clock::now();
+        // Flushes the batches and the asynchronous queue, if the profile
+        // has them, and waits until the DataReader has what is left
+        entities.writer.extensions().flush();
+        try {
+            entities.writer.wait_for_acknowledgments(DRAIN_TIMEOUT);
+        } catch (const dds::core::TimeoutError&) {
+        }
+        writing = false;
+    });
+
+    uint64_t received = 0;
+    bool draining = false;
+    while (true) {
+        if (!writing) {
+            // One more take after the writer is done, for the last samples
+            if (draining) {
+                break;
+            }
+            draining = true;
+        }
+        entities.waitset.wait(dds::core::Duration::from_millisecs(100));
+        received += entities.reader.take().length();
+    }
+    writer_thread.join();
+    std::chrono::duration<double> write_time = write_end_time - start_time;
+    std::chrono::duration<double> receive_time =
+            std::chrono::steady_clock::now() - start_time;
+
+    results.written = written;
+    results.received = received;
+    results.write_seconds = write_time.count();
+    results.receive_seconds = receive_time.count();
+}
+
+ProfileResults measure_profile(
+        unsigned int domain_id,
+        const std::string& profile,
+        unsigned int latency_samples,
+        std::chrono::seconds duration)
+{
+    ProfileEntities entities(domain_id, profile);
+    wait_for_match(entities);
+
+    ProfileResults results;
+    measure_latency(entities, latency_samples, results.latency);
+    measure_throughput(entities, duration, results);
+    return results;
+}
+
+void run_example(
+        unsigned int domain_id,
+        unsigned int latency_samples,
+        unsigned int duration,
+        const std::string& qos_profile)
+{
+    if (latency_samples == 0) {
+        latency_samples = DEFAULT_LATENCY_SAMPLES;
+    }
+    std::vector<std::string> profiles = DEFAULT_PROFILES;
+    if (!qos_profile.empty()) {
+        profiles = { qos_profile };
+    }
+    std::chrono::seconds seconds(std::max(1u, duration));
+
+    for (const auto& profile : profiles) {
+        if (!running) {
+            break;
+        }
+        std::cout << profile << std::endl;
+        ProfileResults results;
+        try {
+            results = measure_profile(
+                    domain_id,
+                    profile,
+                    latency_samples,
+                    seconds);
+        } catch (const std::exception& ex) {
+            // For example, no privileges for real-time receive threads
+            std::cout << "  Skipped: " << ex.what() << std::endl;
+            continue;
+        }
+
+        std::cout << "  Latency (us): ";
+        results.latency.print(std::cout, 1000);
+        std::cout << "  Throughput: "
+                  << results.written / std::max(results.write_seconds, 1e-9)
+                  << " msgs/s written, "
+                  << results.received
+                        / std::max(results.receive_seconds, 1e-9)
+                  << " msgs/s received, "
+                  << results.written
+                        - std::min(results.written, results.received)
+                  << " lost" << std::endl;
+    }
+}
+
+// Sets Connext verbosity to help debugging
+void set_verbosity(rti::config::Verbosity verbosity)
+{
+    rti::config::Logger::instance().verbosity(verbosity);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::PARSE_RETURN_EXIT) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::PARSE_RETURN_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Enables different levels of debugging output
+    set_verbosity(arguments.verbosity);
+
+    try {
+        run_example(
+                arguments.domain_id,
+                arguments.sample_count,
+                arguments.duration,
+                arguments.qos_profile);
+    } catch (const std::exception& ex) {
+        // This will catch DDS exceptions
+        std::cerr << "Exception in benchmark_main(): " << ex.what()
+                  << std::endl;
+        teardown_signal_handlers();
+        return EXIT_FAILURE;
+    }
+
+    teardown_signal_handlers();
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
@@ -10,27 +10,172 @@
  * to use the software.
  */
 
+#include <algorithm>
+#include <chrono>
+#include <exception>
 #include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <dds/pub/ddspub.hpp>
-#include <rti/util/util.hpp>  // for sleep()
 #include <rti/config/Logger.hpp>  // for logging
 // Or simply include <dds/dds.hpp> 
 
 #include "temperature.hpp"
 #include "application.hpp"  // Argument parsing
+#include "metrics.hpp"
+#include "temperature_writer.hpp"
 
 using namespace application;
 
+// Writes that take longer than this are counted as stalls
+const std::chrono::milliseconds SLOW_WRITE_THRESHOLD(1);
+
+// Time a writer thread spent blocked in DataWriter::write()
+struct WriteStats {
+    std::chrono::nanoseconds total { 0 };
+    std::chrono::nanoseconds longest { 0 };
+    uint64_t slow_writes = 0;
+
+    void add(std::chrono::nanoseconds write_time)
+    {
+        total += write_time;
+        longest = std::max(longest, write_time);
+        if (write_time > SLOW_WRITE_THRESHOLD) {
+            slow_writes++;
+        }
+    }
+};
+
+// Writes the temperature of each of the given sensors in turn, so that every
+// sensor publishes at 'rate' samples per second. Returns the number of
+// samples written, and adds the time spent in write() to 'write_stats'.
+uint64_t publish_sensors(
+        dds::pub::DataWriter<Temperature>& writer,
+        const std::vector<std::string>& sensor_ids,
+        unsigned int sample_count,
+        RateScheduler& scheduler,
+        bool print_writes,
+        WriteStats& write_stats)
+{
+    // Create one data sample per sensor up front, so the sensor_id string
+    // is not copied on every write
+    std::vector<Temperature> samples(sensor_ids.size());
+    // Register each sensor (instance) once. Writing with the returned
+    // handle saves hashing the sensor_id key on every write
+    std::vector<dds::core::InstanceHandle> instance_handles;
+    instance_handles.reserve(sensor_ids.size());
+    for (size_t i = 0; i < sensor_ids.size(); i++) {
+        samples[i].sensor_id(sensor_ids[i]);
+        instance_handles.push_back(writer.register_instance(samples[i]));
+    }
+
+    MetricsRegistry::Counter samples_written = metrics().counter(
+            "temperature_samples_written_total",
+            "Samples written");
+    MetricsRegistry::Counter write_time = metrics().counter(
+            "temperature_write_seconds_total",
+            "Time spent in DataWriter::write()",
+            1e-9);
+
+    // rand() takes a lock, which would serialize the writer threads
+    std::minstd_rand random_engine(std::random_device {}());
+    std::uniform_int_distribution<int> random_degrees(30, 32);
+
+    // sample_count is per sensor
+    uint64_t total_count = static_cast<uint64_t>(sample_count) * samples.size();
+    uint64_t count = 0;
+    size_t next_sensor = 0;
+    for (; running && (count < total_count || sample_count == 0); count++) {
+        // Wait for the start of this sample's period. The deadlines are
+        // absolute, so the time spent writing does not slow the rate down
+        if (!scheduler.wait()) {
+            break;  // Control-C
+        }
+
+        // Modify the data to be written here
+        Temperature& sample = samples[next_sensor];
+        sample.degrees(random_degrees(random_engine));
+
+        if (print_writes) {
+            console.print("Writing ChocolateTemperature, count ", count);
+        }
+
+        auto write_start = std::chrono::steady_clock::now();
+        writer.write(sample, instance_handles[next_sensor]);
+        auto write_duration =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - write_start);
+        write_time.add(write_duration.count());
+        write_stats.add(write_duration);
+        samples_written.add();
+
+        if (++next_sensor == samples.size()) {
+            next_sensor = 0;
+        }
+    }
+    scheduler.stop();
+
+    return count;
+}
+
 void run_example(
         unsigned int domain_id,
         unsigned int sample_count,
-        const std::string& sensor_id)
+        const std::string& sensor_id,
+        unsigned int batch_size,
+        unsigned int batch_flush_us,
+        bool async_publish,
+        unsigned int flow_rate,
+        unsigned int flow_burst,
+        double rate,
+        OverrunPolicy overrun_policy,
+        unsigned int spin_us,
+        unsigned int sensors,
+        unsigned int threads,
+        const std::string& metrics_file,
+        unsigned int metrics_port,
+        std::string qos_profile)
 {
+    // A flow controller only applies to asynchronous publishing
+    async_publish = async_publish || flow_rate > 0;
+
+    // Without --qos-profile, pick the profile for the options given
+    if (qos_profile.empty()) {
+        qos_profile = default_writer_profile(async_publish, batch_size);
+    }
+
+    // By default write one sample every 4 seconds. When batching, write as
+    // fast as possible unless a rate is given
+    if (rate == 0 && batch_size == 0) {
+        rate = 0.25;
+    }
+    sensors = std::max(1u, sensors);
+    threads = std::max(1u, std::min(threads, sensors));
+    // Printing every write would limit the rate more than DDS does
+    bool print_writes = batch_size == 0 && rate * sensors <= 10;
+
+    // In fleet mode (more than one sensor), the sensors are named
+    // <sensor-id>_0 ... <sensor-id>_<N-1> and dealt round-robin to the
+    // writer threads
+    std::vector<std::vector<std::string>> thread_sensor_ids(threads);
+    for (unsigned int i = 0; i < sensors; i++) {
+        std::string id = sensor_id;
+        if (sensors > 1) {
+            id = (sensor_id.empty() ? "sensor" : sensor_id) + "_"
+                    + std::to_string(i);
+        }
+        thread_sensor_ids[i % threads].push_back(id);
+    }
+
     // A DomainParticipant allows an application to begin communicating in
     // a DDS domain. Typically there is one DomainParticipant per application.
     // DomainParticipant QoS is configured in USER_QOS_PROFILES.xml
-    dds::domain::DomainParticipant participant(domain_id);
+    dds::domain::DomainParticipant participant(
+            domain_id,
+            dds::core::QosProvider::Default().participant_qos(qos_profile));
 
     // A Topic has a name and a datatype. Create a Topic named
     // "ChocolateTemperature" with type Temperature
@@ -40,26 +185,199 @@ void run_example(
     // Publisher QoS is configured in USER_QOS_PROFILES.xml
     dds::pub::Publisher publisher(participant);
 
-    // This DataWriter writes data on Topic "ChocolateTemperature"
-    // DataWriter QoS is configured in USER_QOS_PROFILES.xml
-    dds::pub::DataWriter<Temperature> writer(publisher, topic);
+    // With --flow-rate, the asynchronous publishing thread sends samples
+    // through a token-bucket flow controller. It must exist before the
+    // DataWriters that use it are created.
+    rti::pub::FlowController flow_controller(dds::core::null);
+    std::string flow_controller_name;
+    if (flow_rate > 0) {
+        flow_controller =
+                create_flow_controller(participant, flow_rate, flow_burst);
+        flow_controller_name = FLOW_CONTROLLER_NAME;
+    }
 
-    // Create data sample for writing
-    Temperature sample;
-    for (int count = 0; running && (count < sample_count || sample_count == 0);
-         count++) {
-        // Modify the data to be written here
-        sample.sensor_id(sensor_id);
-        sample.degrees(rand() % 3 + 30);  // Random number between 30 and 32
+    // These DataWriters write data on Topic "ChocolateTemperature". Each
+    // thread gets its own DataWriter so the threads never wait for each
+    // other, but they all share the DomainParticipant: discovery and
+    // transport resources are paid for once, not once per sensor.
+    std::vector<dds::pub::DataWriter<Temperature>> writers;
+    std::vector<RateScheduler> schedulers;
+    for (unsigned int t = 0; t < threads; t++) {
+        writers.push_back(create_writer(
+                publisher,
+                topic,
+                qos_profile,
+                batch_size,
+                batch_flush_us,
+                async_publish,
+                flow_controller_name));
+        // Exercise: Change the rate to write one temperature every 10 ms
+        schedulers.push_back(RateScheduler(
+                rate * thread_sensor_ids[t].size(),
+                overrun_policy,
+                std::chrono::microseconds(spin_us)));
+    }
 
-        std::cout << "Writing ChocolateTemperature, count " << count
-                  << std::endl;
+    // The state of the DataWriter queues is read each time the metrics are
+    // exported
+    MetricsExporter exporter(metrics(), metrics_file, metrics_port);
+    exporter.add(
+            "temperature_writer_cache_samples",
+            "Samples in the DataWriter queues",
+            "gauge",
+            [&writers]() {
+                double samples = 0;
+                for (auto& writer : writers) {
+                    samples += writer.extensions()
+                                       .datawriter_cache_status()
+                                       .sample_count();
+                }
+                return samples;
+            });
+    exporter.add(
+            "temperature_writer_unacknowledged_samples",
+            "Samples not yet acknowledged by all the reliable DataReaders",
+            "gauge",
+            [&writers]() {
+                double samples = 0;
+                for (auto& writer : writers) {
+                    samples += writer.extensions()
+                                       .reliable_writer_cache_changed_status()
+                                       .unacknowledged_sample_count();
+                }
+                return samples;
+            });
+    exporter.add(
+            "temperature_writer_filtered_samples_total",
+            "Samples not sent because they did not pass the content filter "
+            "of a DataReader",
+            "counter",
+            [&writers]() {
+                double samples = 0;
+                for (auto& writer : writers) {
+                    samples += writer.extensions()
+                                       .datawriter_protocol_status()
+                                       .filtered_sample_count();
+                }
+                return samples;
+            });
+    exporter.add(
+            "temperature_matched_subscriptions",
+            "DataReaders matched with the DataWriters",
+            "gauge",
+            [&writers]() {
+                return writers[0].publication_matched_status().current_count();
+            });
+    exporter.start();
+
+    auto start_time = std::chrono::steady_clock::now();
+    std::vector<uint64_t> counts(threads, 0);
+    std::vector<WriteStats> write_stats(threads);
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> writer_threads;
+    for (unsigned int t = 0; t < threads; t++) {
+        writer_threads.push_back(std::thread([&, t]() {
+            try {
+                counts[t] = publish_sensors(
+                        writers[t],
+                        thread_sensor_ids[t],
+                        sample_count,
+                        schedulers[t],
+                        print_writes,
+                        write_stats[t]);
+            } catch (...) {
+                // Stop the other threads too; the error is rethrown below
+                errors[t] = std::current_exception();
+                running = false;
+            }
+        }));
+    }
+    for (auto& writer_thread : writer_threads) {
+        writer_thread.join();
+    }
+    // The rates below only count the time spent writing, not the time
+    // spent sending the last samples after the writer threads stopped
+    auto end_time = std::chrono::steady_clock::now();
+    for (auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Send the last, partially filled batches right away instead of
+    // waiting for max_flush_delay
+    if (batch_size > 0) {
+        for (auto& writer : writers) {
+            writer.extensions().flush();
+        }
+    }
+    // Samples still queued for the publishing thread are lost when the
+    // DataWriter is deleted
+    if (async_publish) {
+        for (auto& writer : writers) {
+            writer.extensions().wait_for_asynchronous_publication(
+                    dds::core::Duration(10));
+        }
+    }
+    for (auto& writer : writers) {
+        wait_for_acknowledgments_on_exit(writer);
+    }
 
-        writer.write(sample);
+    std::chrono::duration<double> elapsed = end_time - start_time;
+    std::chrono::duration<double> drain_time =
+            std::chrono::steady_clock::now() - end_time;
+    console.stop();  // Print the queued lines before the summary
+    uint64_t count = 0;
+    WriteStats all_write_stats;
+    for (unsigned int t = 0; t < threads; t++) {
+        count += counts[t];
+        all_write_stats.total += write_stats[t].total;
+        all_write_stats.longest =
+                std::max(all_write_stats.longest, write_stats[t].longest);
+        all_write_stats.slow_writes += write_stats[t].slow_writes;
+        if (threads > 1) {
+            std::cout << "Thread " << t << ": "
+                      << thread_sensor_ids[t].size() << " sensors. ";
+        }
+        schedulers[t].print_report(std::cout);
+    }
+    std::cout << "Wrote " << count << " samples from " << sensors
+              << " sensors in " << elapsed.count() << " s ("
+              << (elapsed.count() > 0 ? count / elapsed.count() : 0)
+              << " msgs/s), then " << drain_time.count()
+              << " s sending the last samples" << std::endl;
 
-        // Exercise: Change this to sleep 10 ms in between writing temperatures
-        rti::util::sleep(dds::core::Duration(4));
+    // Compare these numbers with and without --async: with synchronous
+    // publishing, write() sends the sample itself, and blocks while the
+    // reliable queue is full
+    std::chrono::duration<double> blocked = all_write_stats.total;
+    double run_seconds = elapsed.count() * threads;
+    std::cout << "Time blocked in write() ("
+              << (async_publish ? "asynchronous" : "synchronous")
+              << " publishing): " << blocked.count() << " s ("
+              << (run_seconds > 0 ? 100 * blocked.count() / run_seconds : 0)
+              << "% of the writer threads' time), longest write "
+              << std::chrono::duration_cast<std::chrono::microseconds>(
+                         all_write_stats.longest)
+                         .count()
+              << " us, " << all_write_stats.slow_writes
+              << " writes longer than "
+              << SLOW_WRITE_THRESHOLD.count() << " ms" << std::endl;
+
+    // With subscribers using --filter, the DataWriters only send the samples
+    // that pass their filters
+    uint64_t pushed_samples = 0;
+    uint64_t pushed_bytes = 0;
+    uint64_t filtered_samples = 0;
+    for (auto& writer : writers) {
+        auto protocol_status = writer.extensions().datawriter_protocol_status();
+        pushed_samples += protocol_status.pushed_sample_count();
+        pushed_bytes += protocol_status.pushed_sample_bytes();
+        filtered_samples += protocol_status.filtered_sample_count();
     }
+    std::cout << "Sent " << pushed_samples << " samples (" << pushed_bytes
+              << " bytes); " << filtered_samples
+              << " samples filtered out by the DataWriters" << std::endl;
 }
 
 // Sets Connext verbosity to help debugging
@@ -81,19 +399,36 @@ int main(int argc, char *argv[])
 
     // Enables different levels of debugging output
     set_verbosity(arguments.verbosity);
+    console.start(arguments.output_mode);
 
     try {
         run_example(
                 arguments.domain_id,
                 arguments.sample_count,
-                arguments.sensor_id);
+                arguments.sensor_id,
+                arguments.batch_size,
+                arguments.batch_flush_us,
+                arguments.async_publish,
+                arguments.flow_rate,
+                arguments.flow_burst,
+                arguments.rate,
+                arguments.overrun_policy,
+                arguments.spin_us,
+                arguments.sensors,
+                arguments.threads,
+                arguments.metrics_file,
+                arguments.metrics_port,
+                arguments.qos_profile);
     } catch (const std::exception& ex) {
         // This will catch DDS exceptions
         std::cerr << "Exception in publisher_main(): " << ex.what()
                   << std::endl;
+        teardown_signal_handlers();
         return EXIT_FAILURE;
     }
 
+    teardown_signal_handlers();
+
     // Releases the memory used by the participant factory.  Optional at
     // application shutdown
     dds::domain::DomainParticipant::finalize_participant_factory();
@@ -0,0 +1,161 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+// Asks the TemperatureQuery service of a temperature_subscriber started with
+// --query-workers for the latest reading of the sensors, or for their
+// statistics over one of its --stats-windows, and prints the reply. With
+// --history, also prints the readings of one sensor over the last seconds,
+// from the subscriber's own --history.
+//
+//   temperature_query [-id <sensor>] [--window <s>] [--history <s>]
+//                     [-d <domain>]
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <dds/domain/ddsdomain.hpp>
+#include <rti/config/Logger.hpp>  // for logging
+// Or simply include <dds/dds.hpp>
+
+#include "temperature_query.hpp"
+#include "application.hpp"  // Argument parsing
+#include "temperature_query_service.hpp"
+
+using namespace application;
+
+// Includes the discovery of the subscriber
+const std::chrono::milliseconds DISCOVERY_TIMEOUT(10000);
+const dds::core::Duration REPLY_TIMEOUT(5);
+
+void run_example(
+        unsigned int domain_id,
+        const std::string& sensor_id,
+        unsigned int window,
+        unsigned int history_seconds,
+        std::string qos_profile)
+{
+    if (qos_profile.empty()) {
+        qos_profile = TEMPERATURE_QUERY_PROFILE;
+    }
+    dds::domain::DomainParticipant participant(
+            domain_id,
+            dds::core::QosProvider::Default().participant_qos(qos_profile));
+    TemperatureQueryRequester requester(
+            query_requester_params(participant, qos_profile));
+    if (!wait_for_replier(requester, DISCOVERY_TIMEOUT)) {
+        throw std::runtime_error(
+                "No TemperatureQuery service found: start "
+                "temperature_subscriber with --query-workers");
+    }
+
+    TemperatureQuery query;
+    if (!sensor_id.empty()) {
+        query.sensor_ids().push_back(sensor_id);
+    }
+    query.window_seconds(window);
+    query.history_seconds(history_seconds);
+    TemperatureQueryReply reply;
+    if (!send_query(requester, query, REPLY_TIMEOUT, reply)) {
+        throw std::runtime_error("No reply to the query");
+    }
+    if (!reply.error().empty()) {
+        throw std::runtime_error(reply.error());
+    }
+
+    dds::core::Time now = participant.current_time();
+    int64_t now_ns = now.sec() * 1000000000LL + now.nanosec();
+    for (const auto& result : reply.sensors()) {
+        std::cout << result.sensor_id() << ": ";
+        if (!result.found()) {
+            std::cout << "no readings" << std::endl;
+            continue;
+        }
+        std::cout << result.degrees() << " degrees, "
+                  << (now_ns - result.timestamp()) / 1e6 << " ms ago";
+        if (window > 0) {
+            std::cout << "; " << window << " s: ";
+            if (result.count() == 0) {
+                std::cout << "no samples";
+            } else {
+                std::cout << result.count() << " samples, min "
+                          << result.min() << ", max " << result.max()
+                          << ", mean " << result.mean() << ", stddev "
+                          << result.stddev();
+            }
+        }
+        std::cout << std::endl;
+    }
+    if (reply.omitted_count() > 0) {
+        std::cout << "(" << reply.omitted_count()
+                  << " more sensors: query them by ID)" << std::endl;
+    }
+
+    if (history_seconds > 0) {
+        std::cout << "Last " << history_seconds << " s: "
+                  << reply.history().size() << " readings";
+        if (reply.omitted_history_count() > 0) {
+            std::cout << " (and " << reply.omitted_history_count()
+                      << " older ones)";
+        }
+        std::cout << std::endl;
+        for (const auto& reading : reply.history()) {
+            std::cout << "    " << (now_ns - reading.timestamp()) / 1e6
+                      << " ms ago: " << reading.degrees() << " degrees"
+                      << std::endl;
+        }
+    }
+}
+
+// Sets Connext verbosity to help debugging
+void set_verbosity(rti::config::Verbosity verbosity)
+{
+    rti::config::Logger::instance().verbosity(verbosity);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::PARSE_RETURN_EXIT) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::PARSE_RETURN_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Enables different levels of debugging output
+    set_verbosity(arguments.verbosity);
+
+    try {
+        run_example(
+                arguments.domain_id,
+                arguments.sensor_id,
+                arguments.query_window,
+                arguments.history_seconds,
+                arguments.qos_profile);
+    } catch (const std::exception& ex) {
+        // This will catch DDS exceptions
+        std::cerr << "Exception in query_main(): " << ex.what() << std::endl;
+        teardown_signal_handlers();
+        return EXIT_FAILURE;
+    }
+
+    teardown_signal_handlers();
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,265 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+// Measures the round-trip latency and the replies/s of the TemperatureQuery
+// service of a running temperature_subscriber --query-workers <n>.
+//
+// --clients client threads, each with its own requester, send the same
+// query (-id and --window, as temperature_query) for --duration seconds:
+//   - one after the other, as soon as the reply arrives (closed loop), to
+//     find the most replies/s the service can send
+//   - or --rate queries per second each, to measure the latency at a given
+//     load. A reply that takes longer than the period also delays the
+//     queries after it: the latency they would have seen is recorded too.
+// Compare different --query-workers in the subscriber under the same load.
+//
+//   temperature_query_benchmark [--clients <n>] [-r <queries/s>]
+//                               [--duration <s>] [-id <sensor>]
+//                               [--window <s>]
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dds/domain/ddsdomain.hpp>
+#include <rti/config/Logger.hpp>  // for logging
+
+#include "temperature_query.hpp"
+#include "application.hpp"  // Argument parsing
+#include "hdr_histogram.hpp"
+#include "temperature_query_service.hpp"
+
+using namespace application;
+
+// Includes the discovery of the subscriber
+const std::chrono::milliseconds DISCOVERY_TIMEOUT(10000);
+const dds::core::Duration REPLY_TIMEOUT(5);
+
+// Sends queries with its own requester, and records their round-trip time
+class QueryClient {
+public:
+    QueryClient(
+            dds::domain::DomainParticipant participant,
+            const std::string& qos_profile,
+            const TemperatureQuery& query,
+            double rate)
+            : requester_(query_requester_params(participant, qos_profile)),
+              query_(query),
+              rate_(rate),
+              reply_count_(0),
+              timeout_count_(0),
+              sensor_count_(0)
+    {
+    }
+
+    bool wait_for_service()
+    {
+        return wait_for_replier(requester_, DISCOVERY_TIMEOUT);
+    }
+
+    // Sends queries until 'end_time'. Errors are rethrown by
+    // rethrow_error().
+    void run(std::chrono::steady_clock::time_point end_time)
+    {
+        try {
+            RateScheduler scheduler(rate_, OverrunPolicy::CATCH_UP);
+            uint64_t expected_interval_ns =
+                    rate_ > 0 ? static_cast<uint64_t>(1e9 / rate_) : 0;
+            TemperatureQueryReply reply;
+            while (running && std::chrono::steady_clock::now() < end_time) {
+                if (!scheduler.wait()) {
+                    break;  // Control-C
+                }
+                auto start = std::chrono::steady_clock::now();
+                if (!send_query(requester_, query_, REPLY_TIMEOUT, reply)) {
+                    timeout_count_++;
+                    continue;
+                }
+                std::chrono::nanoseconds round_trip =
+                        std::chrono::steady_clock::now() - start;
+                latency_.record_corrected(
+                        static_cast<uint64_t>(round_trip.count()),
+                        expected_interval_ns);
+                reply_count_++;
+                sensor_count_ += reply.sensors().size();
+                if (!reply.error().empty()) {
+                    throw std::runtime_error(reply.error());
+                }
+            }
+        } catch (...) {
+            error_ = std::current_exception();
+        }
+    }
+
+    void rethrow_error() const
+    {
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+    }
+
+    const HdrHistogram& latency() const
+    {
+        return latency_;
+    }
+
+    uint64_t reply_count() const
+    {
+        return reply_count_;
+    }
+
+    uint64_t timeout_count() const
+    {
+        return timeout_count_;
+    }
+
+    uint64_t sensor_count() const
+    {
+        return sensor_count_;
+    }
+
+private:
+    TemperatureQueryRequester requester_;
+    TemperatureQuery query_;
+    double rate_;
+    HdrHistogram latency_;
+    uint64_t reply_count_;
+    uint64_t timeout_count_;
+    uint64_t sensor_count_;  // Sensors in all the replies
+    std::exception_ptr error_;
+};
+
+void run_example(
+        unsigned int domain_id,
+        unsigned int client_count,
+        double rate,
+        unsigned int duration,
+        const std::string& sensor_id,
+        unsigned int window,
+        std::string qos_profile)
+{
+    if (qos_profile.empty()) {
+        qos_profile = TEMPERATURE_QUERY_PROFILE;
+    }
+    client_count = std::max(1u, client_count);
+    dds::domain::DomainParticipant participant(
+            domain_id,
+            dds::core::QosProvider::Default().participant_qos(qos_profile));
+
+    TemperatureQuery query;
+    if (!sensor_id.empty()) {
+        query.sensor_ids().push_back(sensor_id);
+    }
+    query.window_seconds(window);
+    std::vector<std::unique_ptr<QueryClient>> clients;
+    for (unsigned int i = 0; i < client_count; i++) {
+        clients.push_back(std::unique_ptr<QueryClient>(
+                new QueryClient(participant, qos_profile, query, rate)));
+    }
+    for (auto& client : clients) {
+        if (!client->wait_for_service()) {
+            throw std::runtime_error(
+                    "No TemperatureQuery service found: start "
+                    "temperature_subscriber with --query-workers");
+        }
+    }
+
+    std::cout << client_count << " clients, ";
+    if (rate > 0) {
+        std::cout << rate << " queries/s each";
+    } else {
+        std::cout << "closed loop";
+    }
+    std::cout << ", " << std::max(1u, duration) << " s" << std::endl;
+    auto start_time = std::chrono::steady_clock::now();
+    auto end_time = start_time + std::chrono::seconds(std::max(1u, duration));
+    std::vector<std::thread> client_threads;
+    for (auto& client : clients) {
+        QueryClient *query_client = client.get();
+        client_threads.push_back(std::thread(
+                [query_client, end_time]() { query_client->run(end_time); }));
+    }
+    for (auto& thread : client_threads) {
+        thread.join();
+    }
+    std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start_time;
+
+    HdrHistogram latency;
+    uint64_t replies = 0;
+    uint64_t timeouts = 0;
+    uint64_t sensors = 0;
+    for (auto& client : clients) {
+        client->rethrow_error();
+        latency.merge(client->latency());
+        replies += client->reply_count();
+        timeouts += client->timeout_count();
+        sensors += client->sensor_count();
+    }
+    std::cout << replies << " replies (" << replies / elapsed.count()
+              << " replies/s, " << (replies > 0 ? sensors / replies : 0)
+              << " sensors each), " << timeouts << " timed out" << std::endl
+              << "Round trip (us): ";
+    latency.print(std::cout, 1000);
+}
+
+// Sets Connext verbosity to help debugging
+void set_verbosity(rti::config::Verbosity verbosity)
+{
+    rti::config::Logger::instance().verbosity(verbosity);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::PARSE_RETURN_EXIT) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::PARSE_RETURN_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Enables different levels of debugging output
+    set_verbosity(arguments.verbosity);
+
+    try {
+        run_example(
+                arguments.domain_id,
+                arguments.clients,
+                arguments.rate,
+                arguments.duration,
+                arguments.sensor_id,
+                arguments.query_window,
+                arguments.qos_profile);
+    } catch (const std::exception& ex) {
+        // This will catch DDS exceptions
+        std::cerr << "Exception in benchmark_main(): " << ex.what()
+                  << std::endl;
+        teardown_signal_handlers();
+        return EXIT_FAILURE;
+    }
+
+    teardown_signal_handlers();
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,336 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef TEMPERATURE_QUERY_SERVICE_HPP
+#define TEMPERATURE_QUERY_SERVICE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dds/domain/ddsdomain.hpp>
+#include <rti/request/rtirequest.hpp>
+
+#include "temperature_query.hpp"
+#include "last_value_cache.hpp"
+#include "rolling_statistics.hpp"
+#include "worker_pool.hpp"
+
+namespace application {
+
+// The requesters and the replier find each other by this name: it is the
+// prefix of the request and reply topics
+const std::string TEMPERATURE_QUERY_SERVICE = "TemperatureQuery";
+const std::string TEMPERATURE_QUERY_PROFILE =
+        "ChocolateFactoryLibrary::TemperatureQueryProfile";
+
+// Answers TemperatureQuery requests from the readings a subscriber keeps in
+// memory: the latest reading of each sensor from a LastValueCache, the
+// statistics over a window from a callback, since the subscriber spreads
+// its RollingStatistics over its workers, and the past readings of a sensor
+// from another callback, which reads the subscriber's TemperatureHistory.
+//
+// A thread takes the requests as they arrive and hands them to a pool of
+// workers, one at a time in turn, so a slow query (e.g. the statistics of
+// all the sensors) does not delay the queries behind it. Each worker sends
+// its replies with the same replier; the replies are matched to their
+// request by the requester, so they can be sent in any order.
+class TemperatureQueryService {
+public:
+    // Fills the statistics of a sensor over a window. Called from the
+    // workers: it must be thread-safe.
+    typedef std::function<bool(
+            const std::string&,
+            std::chrono::seconds,
+            RollingStatistics::Summary&)>
+            WindowStatistics;
+
+    // Calls the function it is given with every reading of a sensor over
+    // the last window, oldest first. Returns false if the subscriber keeps
+    // no history. Called from the workers: it must be thread-safe.
+    typedef std::function<bool(
+            const std::string&,
+            std::chrono::seconds,
+            std::function<void(int64_t, int32_t)>)>
+            HistoryReadings;
+
+    // history_readings is empty when the subscriber keeps no history
+    TemperatureQueryService(
+            dds::domain::DomainParticipant participant,
+            const std::string& qos_profile,
+            unsigned int worker_count,
+            const LastValueCache& last_values,
+            const std::vector<unsigned int>& windows,
+            WindowStatistics window_statistics,
+            HistoryReadings history_readings)
+            : replier_(replier_params(participant, qos_profile)),
+              last_values_(last_values),
+              windows_(windows),
+              window_statistics_(window_statistics),
+              history_readings_(history_readings),
+              workers_(
+                      std::max(1u, worker_count),
+                      [this](unsigned int, const Request& request) {
+                          answer(request);
+                      }),
+              stopping_(false),
+              reply_count_(0)
+    {
+        receive_thread_ = std::thread([this]() { receive(); });
+    }
+
+    ~TemperatureQueryService()
+    {
+        stop();
+    }
+
+    // Answers the requests already taken, then stops the threads
+    void stop()
+    {
+        if (receive_thread_.joinable()) {
+            stopping_ = true;
+            receive_thread_.join();
+        }
+        workers_.stop();
+    }
+
+    uint64_t reply_count() const
+    {
+        return reply_count_;
+    }
+
+    // Prints the replies sent, and the requests each worker answered
+    void print_utilization(std::ostream& out) const
+    {
+        out << "Query service: " << reply_count_ << " replies" << std::endl;
+        workers_.print_utilization(out);
+    }
+
+private:
+    struct Request {
+        TemperatureQuery query;
+        dds::sub::SampleInfo info;  // Identifies the request in the reply
+    };
+
+    static rti::request::ReplierParams replier_params(
+            dds::domain::DomainParticipant participant,
+            const std::string& qos_profile)
+    {
+        dds::core::QosProvider qos_provider = dds::core::QosProvider::Default();
+        rti::request::ReplierParams params(participant);
+        params.service_name(TEMPERATURE_QUERY_SERVICE);
+        params.datawriter_qos(qos_provider.datawriter_qos(qos_profile));
+        params.datareader_qos(qos_provider.datareader_qos(qos_profile));
+        return params;
+    }
+
+    void receive()
+    {
+        unsigned int next_worker = 0;
+        std::vector<std::vector<Request>> batches(workers_.worker_count());
+        while (!stopping_) {
+            // Wake up now and then to check if the service is stopping
+            dds::sub::LoanedSamples<TemperatureQuery> requests =
+                    replier_.receive_requests(
+                            dds::core::Duration::from_millisecs(100));
+            for (const auto& request : requests) {
+                if (!request.info().valid()) {
+                    continue;
+                }
+                Request copy = { request.data(), request.info() };
+                batches[next_worker].push_back(copy);
+                next_worker = (next_worker + 1) % batches.size();
+            }
+            for (unsigned int i = 0; i < batches.size(); i++) {
+                workers_.submit(i, std::move(batches[i]));
+                batches[i].clear();
+            }
+        }
+    }
+
+    void answer(const Request& request)
+    {
+        TemperatureQueryReply reply;
+        const TemperatureQuery& query = request.query;
+        std::chrono::seconds window(query.window_seconds());
+        if (window.count() > 0
+            && std::find(windows_.begin(), windows_.end(), window.count())
+                    == windows_.end()) {
+            std::ostringstream error;
+            error << "No " << window.count() << " s window: the windows are";
+            for (unsigned int length : windows_) {
+                error << " " << length;
+            }
+            reply.error(error.str());
+        } else if (
+                query.history_seconds() > 0
+                && query.sensor_ids().size() != 1) {
+            reply.error("The history can only be queried for one sensor");
+        } else if (query.history_seconds() > 0 && !history_readings_) {
+            reply.error("No history: the subscriber was started without "
+                        "--history");
+        } else if (query.sensor_ids().empty()) {
+            size_t sensor_count = last_values_.sensor_count();
+            for (size_t i = 0; i < sensor_count; i++) {
+                add_result(reply, last_values_.sensor_id(i), window);
+            }
+        } else {
+            for (const auto& sensor_id : query.sensor_ids()) {
+                add_result(reply, sensor_id, window);
+            }
+            if (query.history_seconds() > 0) {
+                add_history(
+                        reply,
+                        query.sensor_ids()[0],
+                        std::chrono::seconds(query.history_seconds()));
+            }
+        }
+
+        replier_.send_reply(reply, request.info);
+        reply_count_++;
+    }
+
+    void add_result(
+            TemperatureQueryReply& reply,
+            const std::string& sensor_id,
+            std::chrono::seconds window)
+    {
+        if (reply.sensors().size()
+            == static_cast<size_t>(MAX_QUERY_SENSORS)) {
+            reply.omitted_count(reply.omitted_count() + 1);
+            return;
+        }
+
+        SensorQueryResult result;
+        result.sensor_id(sensor_id);
+        LastValueCache::Reading reading;
+        result.found(last_values_.read(sensor_id, reading));
+        if (result.found()) {
+            result.degrees(reading.degrees);
+            result.timestamp(reading.source_ns);
+        }
+        RollingStatistics::Summary summary;
+        if (window.count() > 0 && window_statistics_(sensor_id, window, summary)
+            && summary.count > 0) {
+            result.count(summary.count);
+            result.min(summary.min);
+            result.max(summary.max);
+            result.mean(summary.mean);
+            result.stddev(summary.stddev);
+        }
+        reply.sensors().push_back(result);
+    }
+
+    // Adds the latest MAX_HISTORY_READINGS readings of the window
+    void add_history(
+            TemperatureQueryReply& reply,
+            const std::string& sensor_id,
+            std::chrono::seconds window)
+    {
+        std::deque<HistoryReading> latest;
+        uint32_t omitted = 0;
+        history_readings_(
+                sensor_id,
+                window,
+                [&latest, &omitted](int64_t timestamp, int32_t degrees) {
+                    if (latest.size()
+                        == static_cast<size_t>(MAX_HISTORY_READINGS)) {
+                        latest.pop_front();
+                        omitted++;
+                    }
+                    latest.push_back(HistoryReading(timestamp, degrees));
+                });
+        for (const auto& reading : latest) {
+            reply.history().push_back(reading);
+        }
+        reply.omitted_history_count(omitted);
+    }
+
+    rti::request::Replier<TemperatureQuery, TemperatureQueryReply> replier_;
+    const LastValueCache& last_values_;
+    std::vector<unsigned int> windows_;
+    WindowStatistics window_statistics_;
+    HistoryReadings history_readings_;
+    WorkerPool<Request> workers_;
+    std::atomic<bool> stopping_;
+    std::atomic<uint64_t> reply_count_;
+    std::thread receive_thread_;
+};
+
+typedef rti::request::Requester<TemperatureQuery, TemperatureQueryReply>
+        TemperatureQueryRequester;
+
+// The requester side of the service, for the clients
+inline rti::request::RequesterParams query_requester_params(
+        dds::domain::DomainParticipant participant,
+        const std::string& qos_profile)
+{
+    dds::core::QosProvider qos_provider = dds::core::QosProvider::Default();
+    rti::request::RequesterParams params(participant);
+    params.service_name(TEMPERATURE_QUERY_SERVICE);
+    params.datawriter_qos(qos_provider.datawriter_qos(qos_profile));
+    params.datareader_qos(qos_provider.datareader_qos(qos_profile));
+    return params;
+}
+
+// Waits until the requester has discovered a replier, in both directions.
+// A request sent before would not reach it. Returns false after 'timeout'.
+inline bool wait_for_replier(
+        TemperatureQueryRequester& requester,
+        std::chrono::milliseconds timeout)
+{
+    auto request_writer = requester.request_datawriter();
+    auto reply_reader = requester.reply_datareader();
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (request_writer.publication_matched_status().current_count() == 0
+           || reply_reader.subscription_matched_status().current_count() == 0) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return true;
+}
+
+// Sends a query and waits for its reply. Returns false if no reply arrived
+// within 'timeout'.
+inline bool send_query(
+        TemperatureQueryRequester& requester,
+        const TemperatureQuery& query,
+        const dds::core::Duration& timeout,
+        TemperatureQueryReply& reply)
+{
+    rti::core::SampleIdentity request_id = requester.send_request(query);
+    if (!requester.wait_for_replies(1, timeout, request_id)) {
+        return false;
+    }
+    dds::sub::LoanedSamples<TemperatureQueryReply> replies =
+            requester.take_replies(request_id);
+    for (const auto& sample : replies) {
+        if (sample.info().valid()) {
+            reply = sample.data();
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace application
+
+#endif  // TEMPERATURE_QUERY_SERVICE_HPP
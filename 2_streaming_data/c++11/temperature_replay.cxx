@@ -0,0 +1,345 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+// Replays a log recorded with temperature_subscriber --record into the
+// "ChocolateTemperature" topic, to reproduce an incident or to load test
+// subscribers. The samples are written at the times given by their source
+// timestamps, --speed times faster, or as fast as possible (--speed 0).
+// With --threads, the sensors are spread over several writer threads; the
+// samples of a sensor are always written in the recorded order. With
+// --from, the replay starts later in the log, found with its time index.
+//
+//   temperature_replay --replay <dir> [--speed <x>] [--from <s>]
+//                      [--threads <n>]
+//                      [--spin-us <us>] [--batch-size <n>] [--async]
+//                      [--flow-rate <B/s>] [--qos-profile <profile>]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dds/pub/ddspub.hpp>
+#include <rti/config/Logger.hpp>  // for logging
+// Or simply include <dds/dds.hpp>
+
+#include "temperature.hpp"
+#include "application.hpp"  // Argument parsing
+#include "sample_log.hpp"
+#include "temperature_writer.hpp"
+#include "worker_pool.hpp"
+
+using namespace application;
+
+// Samples handed to a writer thread at a time
+const size_t REPLAY_BATCH_SIZE = 256;
+// Batches read ahead for each writer thread, to bound the memory used
+const size_t MAX_QUEUED_BATCHES = 64;
+
+struct ReplaySample {
+    Temperature data;
+    int64_t source_ns;
+};
+
+// Writes samples with one DataWriter, each one when its source timestamp,
+// relative to the first sample of the log and scaled by the speed, is due
+class Replayer {
+public:
+    Replayer(
+            dds::pub::DataWriter<Temperature> writer,
+            double speed,
+            int64_t first_source_ns,
+            RateScheduler::clock::time_point start,
+            std::chrono::nanoseconds spin)
+            : writer_(writer),
+              speed_(speed),
+              first_source_ns_(first_source_ns),
+              start_(start),
+              scheduler_(0, OverrunPolicy::CATCH_UP, spin),
+              count_(0)
+    {
+    }
+
+    void replay(const Temperature& data, int64_t source_ns)
+    {
+        // After an error or control-C, the queued samples are dropped
+        if (!running) {
+            return;
+        }
+        try {
+            if (speed_ > 0) {
+                std::chrono::nanoseconds offset(std::llround(
+                        (source_ns - first_source_ns_) / speed_));
+                if (!scheduler_.wait_until(start_ + offset)) {
+                    return;  // Control-C
+                }
+            }
+            writer_.write(data);
+            count_++;
+        } catch (...) {
+            // Stop the other threads too; the error is rethrown later
+            error_ = std::current_exception();
+            running = false;
+        }
+    }
+
+    void rethrow_error() const
+    {
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+    }
+
+    uint64_t count() const
+    {
+        return count_;
+    }
+
+    // Called after the last sample, so that the achieved rate does not
+    // include sending what is left
+    void stop()
+    {
+        scheduler_.stop();
+    }
+
+    void print_report(std::ostream& out) const
+    {
+        scheduler_.print_report(out);
+    }
+
+private:
+    dds::pub::DataWriter<Temperature> writer_;
+    double speed_;
+    int64_t first_source_ns_;
+    RateScheduler::clock::time_point start_;
+    RateScheduler scheduler_;
+    uint64_t count_;
+    std::exception_ptr error_;
+};
+
+// Reads the log and hands each sample to the writer thread of its sensor.
+// Reading is not paced: it runs ahead of the writers until their queues
+// are full.
+void replay_threads(
+        SampleLogReader& log,
+        SampleLogReader::Record& record,
+        std::vector<std::unique_ptr<Replayer>>& replayers)
+{
+    unsigned int threads = static_cast<unsigned int>(replayers.size());
+    WorkerPool<ReplaySample> workers(
+            threads,
+            [&replayers](unsigned int worker, const ReplaySample& sample) {
+                replayers[worker]->replay(sample.data, sample.source_ns);
+            },
+            MAX_QUEUED_BATCHES);
+
+    std::vector<std::vector<ReplaySample>> batches(threads);
+    std::hash<std::string> hash_sensor_id;
+    do {
+        ReplaySample sample;
+        log.read_sample(record, sample.data);
+        sample.source_ns = record.header->source_ns;
+        unsigned int worker = static_cast<unsigned int>(
+                hash_sensor_id(sample.data.sensor_id()) % threads);
+        batches[worker].push_back(std::move(sample));
+        if (batches[worker].size() == REPLAY_BATCH_SIZE) {
+            workers.submit(worker, std::move(batches[worker]));
+            batches[worker].clear();
+        }
+    } while (running && log.next(record));
+
+    for (unsigned int i = 0; i < threads; i++) {
+        workers.submit(i, std::move(batches[i]));
+    }
+    // Writes what is queued, then stops the threads
+    workers.stop();
+}
+
+void run_example(
+        unsigned int domain_id,
+        const std::string& replay_directory,
+        double speed,
+        double from_seconds,
+        unsigned int threads,
+        unsigned int spin_us,
+        unsigned int batch_size,
+        unsigned int batch_flush_us,
+        bool async_publish,
+        unsigned int flow_rate,
+        unsigned int flow_burst,
+        std::string qos_profile)
+{
+    if (replay_directory.empty()) {
+        throw std::invalid_argument("No log given: use --replay <dir>");
+    }
+    SampleLogReader log(replay_directory);
+    SampleLogReader::Record record;
+    if (!log.next(record)) {
+        std::cout << "The log in " << replay_directory << " is empty"
+                  << std::endl;
+        return;
+    }
+    if (from_seconds > 0) {
+        int64_t from_ns = record.header->reception_ns
+                + std::llround(from_seconds * 1e9);
+        if (!log.seek(from_ns) || !log.next(record)) {
+            std::cout << "The log in " << replay_directory
+                      << " ends before " << from_seconds << " s" << std::endl;
+            return;
+        }
+    }
+
+    async_publish = async_publish || flow_rate > 0;
+    if (qos_profile.empty()) {
+        qos_profile = default_writer_profile(async_publish, batch_size);
+    }
+    threads = std::max(1u, threads);
+
+    dds::domain::DomainParticipant participant(
+            domain_id,
+            dds::core::QosProvider::Default().participant_qos(qos_profile));
+    dds::topic::Topic<Temperature> topic(participant, "ChocolateTemperature");
+    dds::pub::Publisher publisher(participant);
+    rti::pub::FlowController flow_controller(dds::core::null);
+    std::string flow_controller_name;
+    if (flow_rate > 0) {
+        flow_controller =
+                create_flow_controller(participant, flow_rate, flow_burst);
+        flow_controller_name = FLOW_CONTROLLER_NAME;
+    }
+
+    // The same DataWriter setup as temperature_publisher, one DataWriter
+    // per thread
+    std::vector<dds::pub::DataWriter<Temperature>> writers;
+    for (unsigned int t = 0; t < threads; t++) {
+        writers.push_back(create_writer(
+                publisher,
+                topic,
+                qos_profile,
+                batch_size,
+                batch_flush_us,
+                async_publish,
+                flow_controller_name));
+    }
+
+    // The timeline starts now, with the first sample replayed
+    auto start_time = RateScheduler::clock::now();
+    std::vector<std::unique_ptr<Replayer>> replayers;
+    for (auto& writer : writers) {
+        replayers.push_back(std::unique_ptr<Replayer>(new Replayer(
+                writer,
+                speed,
+                record.header->source_ns,
+                start_time,
+                std::chrono::microseconds(spin_us))));
+    }
+    if (threads == 1) {
+        Temperature sample;
+        do {
+            log.read_sample(record, sample);
+            replayers[0]->replay(sample, record.header->source_ns);
+        } while (running && log.next(record));
+    } else {
+        replay_threads(log, record, replayers);
+    }
+    // The rate below only counts the replay, not sending the last samples
+    auto end_time = RateScheduler::clock::now();
+    for (auto& replayer : replayers) {
+        replayer->stop();
+        replayer->rethrow_error();
+    }
+
+    // Send what is left in the batches and asynchronous queues before the
+    // DataWriters are deleted
+    for (auto& writer : writers) {
+        if (batch_size > 0) {
+            writer.extensions().flush();
+        }
+        if (async_publish) {
+            writer.extensions().wait_for_asynchronous_publication(
+                    dds::core::Duration(10));
+        }
+        wait_for_acknowledgments_on_exit(writer);
+    }
+
+    std::chrono::duration<double> elapsed = end_time - start_time;
+    std::chrono::duration<double> drain_time =
+            RateScheduler::clock::now() - end_time;
+    uint64_t count = 0;
+    for (unsigned int t = 0; t < threads; t++) {
+        count += replayers[t]->count();
+        if (threads > 1) {
+            std::cout << "Thread " << t << ": ";
+        }
+        replayers[t]->print_report(std::cout);
+    }
+    std::cout << "Replayed " << count << " samples in " << elapsed.count()
+              << " s (" << (elapsed.count() > 0 ? count / elapsed.count() : 0)
+              << " msgs/s), then " << drain_time.count()
+              << " s sending the last samples" << std::endl;
+}
+
+// Sets Connext verbosity to help debugging
+void set_verbosity(rti::config::Verbosity verbosity)
+{
+    rti::config::Logger::instance().verbosity(verbosity);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::PARSE_RETURN_EXIT) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::PARSE_RETURN_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Enables different levels of debugging output
+    set_verbosity(arguments.verbosity);
+
+    try {
+        run_example(
+                arguments.domain_id,
+                arguments.replay_directory,
+                arguments.replay_speed,
+                arguments.replay_from,
+                arguments.threads,
+                arguments.spin_us,
+                arguments.batch_size,
+                arguments.batch_flush_us,
+                arguments.async_publish,
+                arguments.flow_rate,
+                arguments.flow_burst,
+                arguments.qos_profile);
+    } catch (const std::exception& ex) {
+        // This will catch DDS exceptions
+        std::cerr << "Exception in replay_main(): " << ex.what() << std::endl;
+        teardown_signal_handlers();
+        return EXIT_FAILURE;
+    }
+
+    teardown_signal_handlers();
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
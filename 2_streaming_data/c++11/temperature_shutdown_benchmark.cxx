@@ -0,0 +1,181 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+// Measures how long the subscriber loop takes to stop after control-C.
+//
+// Each round runs the WaitSet loop of temperature_subscriber in a thread,
+// with a ChocolateTemperature DataReader and a 4 s dispatch() timeout, then
+// raises SIGINT at a random time and measures how long the loop takes to
+// return. The -s rounds (default 10) attach shutdown_condition() to the
+// WaitSet, as the examples do. POLLING_ROUNDS more rounds do not, so the loop
+// only sees the stop flag at its next timeout.
+//
+//   temperature_shutdown_benchmark [-s <rounds>] [-d <domain>]
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dds/sub/ddssub.hpp>
+#include <dds/core/ddscore.hpp>
+#include <rti/config/Logger.hpp>  // for logging
+// Or simply include <dds/dds.hpp>
+
+#include "temperature.hpp"
+#include "application.hpp"  // Argument parsing
+
+using namespace application;
+
+const unsigned int DEFAULT_ROUNDS = 10;
+const unsigned int POLLING_ROUNDS = 2;
+const dds::core::Duration DISPATCH_TIMEOUT(4);
+// The signal is raised this long after the loop starts, plus a random part
+// of the dispatch timeout
+const std::chrono::milliseconds MIN_SIGNAL_DELAY(50);
+
+// Runs the loop until control-C, and returns how long it took to stop after
+// the signal
+std::chrono::duration<double, std::milli> measure_shutdown(
+        dds::sub::DataReader<Temperature>& reader,
+        bool attach_shutdown_condition,
+        std::chrono::milliseconds signal_delay)
+{
+    dds::core::cond::StatusCondition status_condition(reader);
+    status_condition.enabled_statuses(
+            dds::core::status::StatusMask::data_available());
+    status_condition.extensions().handler([&reader]() { reader.take(); });
+
+    dds::core::cond::WaitSet waitset;
+    waitset += status_condition;
+    if (attach_shutdown_condition) {
+        waitset += shutdown_condition();
+    }
+
+    std::chrono::steady_clock::time_point stopped_time;
+    std::thread loop([&waitset, &stopped_time]() {
+        while (running) {
+            waitset.dispatch(DISPATCH_TIMEOUT);
+        }
+        stopped_time = std::chrono::steady_clock::now();
+    });
+
+    std::this_thread::sleep_for(signal_delay);
+    auto signal_time = std::chrono::steady_clock::now();
+    raise(SIGINT);
+    loop.join();
+
+    // Wait for the signal to go all the way through, so it cannot trigger
+    // the shutdown condition again after it is reset for the next round
+    while (!shutdown_condition().trigger_value()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    shutdown_condition().trigger_value(false);
+    running = true;
+
+    return stopped_time - signal_time;
+}
+
+void print_latencies(
+        const std::string& name,
+        const std::vector<double>& latencies_ms)
+{
+    if (latencies_ms.empty()) {
+        return;
+    }
+    double sum = 0;
+    for (double latency : latencies_ms) {
+        sum += latency;
+    }
+    std::cout << name << " (ms): min "
+              << *std::min_element(latencies_ms.begin(), latencies_ms.end())
+              << ", mean " << sum / latencies_ms.size() << ", max "
+              << *std::max_element(latencies_ms.begin(), latencies_ms.end())
+              << std::endl;
+}
+
+void run_example(unsigned int domain_id, unsigned int rounds)
+{
+    if (rounds == 0) {
+        rounds = DEFAULT_ROUNDS;
+    }
+
+    dds::domain::DomainParticipant participant(domain_id);
+    dds::topic::Topic<Temperature> topic(participant, "ChocolateTemperature");
+    dds::sub::Subscriber subscriber(participant);
+    dds::sub::DataReader<Temperature> reader(subscriber, topic);
+
+    // Signals at a random point of the dispatch timeout, as control-C would
+    std::minstd_rand random_engine(std::random_device {}());
+    std::uniform_int_distribution<int> random_delay_ms(
+            0,
+            static_cast<int>(DISPATCH_TIMEOUT.to_millisecs()));
+
+    std::vector<double> with_condition;
+    std::vector<double> polling;
+    for (unsigned int i = 0; i < rounds + POLLING_ROUNDS; i++) {
+        bool attach_shutdown_condition = i < rounds;
+        std::chrono::milliseconds delay =
+                MIN_SIGNAL_DELAY
+                + std::chrono::milliseconds(random_delay_ms(random_engine));
+        double latency_ms =
+                measure_shutdown(reader, attach_shutdown_condition, delay)
+                        .count();
+        (attach_shutdown_condition ? with_condition : polling)
+                .push_back(latency_ms);
+    }
+
+    print_latencies("With the shutdown condition", with_condition);
+    print_latencies("Timeout only", polling);
+}
+
+// Sets Connext verbosity to help debugging
+void set_verbosity(rti::config::Verbosity verbosity)
+{
+    rti::config::Logger::instance().verbosity(verbosity);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::PARSE_RETURN_EXIT) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::PARSE_RETURN_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Enables different levels of debugging output
+    set_verbosity(arguments.verbosity);
+
+    try {
+        run_example(arguments.domain_id, arguments.sample_count);
+    } catch (const std::exception& ex) {
+        // This will catch DDS exceptions
+        std::cerr << "Exception in benchmark_main(): " << ex.what()
+                  << std::endl;
+        teardown_signal_handlers();
+        return EXIT_FAILURE;
+    }
+
+    teardown_signal_handlers();
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
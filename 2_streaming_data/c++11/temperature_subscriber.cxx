@@ -11,7 +11,16 @@
  */
 
 #include <algorithm>
+#include <chrono>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <dds/sub/ddssub.hpp>
 #include <dds/core/ddscore.hpp>
@@ -20,44 +29,313 @@
 
 #include "temperature.hpp"
 #include "application.hpp"  // Argument parsing
+#include "batch_kernels.hpp"
+#include "last_value_cache.hpp"
+#include "latency_statistics.hpp"
+#include "metrics.hpp"
+#include "rolling_statistics.hpp"
+#include "sample_log.hpp"
+#include "temperature_history.hpp"
+#include "temperature_query_service.hpp"
+#include "throughput.hpp"  // process_cpu_seconds()
+#include "worker_pool.hpp"
 
 using namespace application;
 
-unsigned int process_data(dds::sub::DataReader<Temperature>& reader)
+// Exercise: change the temperature above which the chocolate is too hot
+const int32_t MAX_TEMPERING_DEGREES = 31;
+// The histogram of the temperatures starts at 20 degrees, one per degree
+const int32_t HISTOGRAM_FIRST_DEGREES = 20;
+const size_t HISTOGRAM_BUCKETS = 20;
+// How often --latest-only reads the sensors without --min-separation
+const unsigned int LATEST_VALUE_PERIOD_MS = 250;
+// Sensors the last-value cache has room for
+const size_t MAX_CACHED_SENSORS = 1024;
+
+// The statistics kept by one worker, or by the thread taking the samples.
+// Only that thread uses 'statistics'. With the query service, it also
+// publishes the summaries of its sensors each time a bucket closes, and the
+// service's threads read those: neither side waits while the other one
+// computes. If a worker receives no samples at all, its published summaries
+// stay as they were at its last sample.
+struct WorkerStatistics {
+    typedef std::unordered_map<std::string, RollingStatistics::WindowSummaries>
+            Summaries;
+
+    WorkerStatistics(
+            const std::vector<std::chrono::seconds>& windows,
+            std::chrono::seconds report_period,
+            bool publish_summaries)
+            : statistics(windows, report_period),
+              publish_summaries(publish_summaries),
+              next_publication(RollingStatistics::clock::time_point::min())
+    {
+    }
+
+    RollingStatistics statistics;
+    const bool publish_summaries;
+    RollingStatistics::clock::time_point next_publication;
+    // Only held to replace or copy the pointer
+    std::mutex published_mutex;
+    std::shared_ptr<const Summaries> published;
+};
+
+// Replaces the summaries the query service reads
+void publish_summaries(
+        WorkerStatistics& statistics,
+        RollingStatistics::clock::time_point now)
+{
+    std::shared_ptr<const WorkerStatistics::Summaries> summaries =
+            std::make_shared<const WorkerStatistics::Summaries>(
+                    statistics.statistics.all_summaries(now));
+    statistics.next_publication = statistics.statistics.bucket_end(now);
+    {
+        std::lock_guard<std::mutex> lock(statistics.published_mutex);
+        statistics.published.swap(summaries);
+    }
+    // The previous summaries are freed here, outside the lock
+}
+
+// Prints the statistics summary in one piece, so the summaries printed by
+// different workers do not mix
+void print_statistics(
+        RollingStatistics& statistics,
+        RollingStatistics::clock::time_point now)
+{
+    std::ostringstream summary;
+    statistics.print_summary(summary, now);
+    std::cout << summary.str() << std::flush;
+}
+
+// Prints the latency summary in one piece, like print_statistics()
+void print_latency(
+        LatencyStatistics& latency,
+        LatencyStatistics::clock::time_point now,
+        size_t max_sensors = 10)
+{
+    std::ostringstream summary;
+    latency.print_summary(summary, now, max_sensors);
+    std::cout << summary.str() << std::flush;
+}
+
+// Nanoseconds since the epoch, like the timestamps in the SampleInfo
+int64_t time_ns(const dds::core::Time& time)
+{
+    return time.sec() * 1000000000LL + time.nanosec();
+}
+
+MetricsRegistry::Counter samples_taken = metrics().counter(
+        "temperature_samples_taken_total",
+        "Valid samples taken from the DataReader");
+MetricsRegistry::Counter invalid_samples = metrics().counter(
+        "temperature_invalid_samples_total",
+        "Samples taken that only notify an instance state change");
+MetricsRegistry::Counter samples_processed = metrics().counter(
+        "temperature_samples_processed_total",
+        "Samples processed, by the dispatch thread or the workers");
+
+// Processes one sample
+void process_sample(const Temperature& data, WorkerStatistics& statistics)
+{
+    console.print(data);
+    samples_processed.add();
+
+    auto now = RollingStatistics::clock::now();
+    statistics.statistics.add(data.sensor_id(), data.degrees(), now);
+    if (statistics.publish_summaries && now >= statistics.next_publication) {
+        publish_summaries(statistics, now);
+    }
+    if (statistics.statistics.report_due(now)) {
+        print_statistics(statistics.statistics, now);
+    }
+}
+
+unsigned int process_data(
+        dds::sub::DataReader<Temperature>& reader,
+        BatchSummary& batch_summary,
+        WorkerStatistics& statistics,
+        LatencyStatistics& latency,
+        LastValueCache& last_values,
+        TemperatureHistory *history,
+        SampleLogWriter *recorder,
+        WorkerPool<Temperature> *workers)
 {
     // Take all samples.  Samples are loaned to application, loan is
     // returned when LoanedSamples destructor called.
     unsigned int samples_read = 0;
     dds::sub::LoanedSamples<Temperature> samples = reader.take();
+
+    // The time the application sees the samples, from the same clock as
+    // the source and reception timestamps
+    int64_t taken_ns =
+            time_ns(reader.subscriber().participant().current_time());
+    for (const auto& sample : samples) {
+        if (sample.info().valid()) {
+            samples_taken.add();
+            int64_t source_ns = time_ns(sample.info().source_timestamp());
+            int64_t reception_ns =
+                    time_ns(sample.info().extensions().reception_timestamp());
+            latency.add(
+                    sample.data().sensor_id(),
+                    source_ns,
+                    reception_ns,
+                    taken_ns);
+            last_values.update(
+                    sample.data().sensor_id(),
+                    sample.data().degrees(),
+                    source_ns);
+            if (history != nullptr) {
+                history->add(
+                        sample.data().sensor_id(),
+                        source_ns,
+                        sample.data().degrees());
+            }
+            if (recorder != nullptr) {
+                recorder->append(sample.data(), source_ns, reception_ns);
+            }
+        } else {
+            invalid_samples.add();
+        }
+    }
+    auto now = LatencyStatistics::clock::now();
+    if (latency.report_due(now)) {
+        print_latency(latency, now);
+    }
+
+    // The totals of all the samples are computed a whole batch at a time,
+    // with vector instructions when available
+    batch_summary.add_samples(samples);
+    if (workers == nullptr) {
+        for (const auto& sample : samples) {
+            if (sample.info().valid()) {
+                samples_read++;
+                process_sample(sample.data(), statistics);
+            }
+        }
+        return samples_read;
+    }
+
+    // Split the samples in one batch per worker. All the samples of a sensor
+    // go to the same worker, which processes them in order. The samples are
+    // copied out of the loan so it can be returned right away.
+    std::vector<std::vector<Temperature>> batches(workers->worker_count());
+    std::hash<std::string> hash_sensor_id;
     for (const auto& sample : samples) {
         if (sample.info().valid()) {
             samples_read++;
-            std::cout << sample.data() << std::endl;
+            size_t worker = hash_sensor_id(sample.data().sensor_id())
+                    % batches.size();
+            batches[worker].push_back(sample.data());
         }
     }
+    for (unsigned int i = 0; i < batches.size(); i++) {
+        workers->submit(i, std::move(batches[i]));
+    }
 
     return samples_read;
 }  // The LoanedSamples destructor returns the loan
 
-void run_example(unsigned int domain_id, unsigned int sample_count)
+// Prints the latest reading of the first 'max_sensors' sensors
+void print_last_values(
+        const LastValueCache& last_values,
+        std::ostream& out,
+        size_t max_sensors = 10)
 {
+    size_t sensor_count = last_values.sensor_count();
+    out << "Last values of " << sensor_count << " sensors";
+    if (last_values.dropped_count() > 0) {
+        out << " (" << last_values.dropped_count()
+            << " updates of further sensors dropped, the cache is full)";
+    }
+    out << std::endl;
+    LastValueCache::Reading reading;
+    for (size_t i = 0; i < sensor_count && i < max_sensors; i++) {
+        last_values.read(i, reading);
+        out << "  " << last_values.sensor_id(i) << ": " << reading.degrees
+            << " degrees (" << reading.update_count << " updates)"
+            << std::endl;
+    }
+}
+
+void run_example(
+        unsigned int domain_id,
+        unsigned int sample_count,
+        unsigned int worker_count,
+        unsigned int stats_period,
+        const std::vector<unsigned int>& stats_windows,
+        unsigned int min_separation_ms,
+        bool latest_only,
+        const std::string& filter,
+        unsigned int history_seconds,
+        const std::string& record_directory,
+        unsigned int segment_size_mb,
+        unsigned int query_workers,
+        const std::string& metrics_file,
+        unsigned int metrics_port,
+        std::string qos_profile)
+{
+    // Without --qos-profile, use the default profile
+    if (qos_profile.empty()) {
+        qos_profile = "ChocolateFactoryLibrary::TemperingTemperatureProfile";
+    }
+    dds::core::QosProvider qos_provider = dds::core::QosProvider::Default();
+
     // A DomainParticipant allows an application to begin communicating in
     // a DDS domain. Typically there is one DomainParticipant per application.
-    // Create a DomainParticipant with default Qos
-    dds::domain::DomainParticipant participant(domain_id);
+    // DomainParticipant QoS is configured in USER_QOS_PROFILES.xml
+    dds::domain::DomainParticipant participant(
+            domain_id,
+            qos_provider.participant_qos(qos_profile));
 
     // A Topic has a name and a datatype. Create a Topic named
     // "ChocolateTemperature" with type Temperature
     dds::topic::Topic<Temperature> topic(participant, "ChocolateTemperature");
 
+    // With --filter, the DataReader subscribes to a ContentFilteredTopic,
+    // and only receives the samples that match the filter expression. The
+    // DataWriters learn the filter through discovery and, by default,
+    // evaluate it themselves for up to 32 DataReaders
+    // (max_remote_reader_filters), so the other samples are never sent to
+    // this subscriber. Samples sent over multicast or in batches are
+    // filtered by the DataReader instead.
+    dds::topic::TopicDescription<Temperature> topic_description = topic;
+    if (!filter.empty()) {
+        topic_description = dds::topic::ContentFilteredTopic<Temperature>(
+                topic,
+                "ChocolateTemperatureFiltered",
+                dds::topic::Filter(filter));
+    }
+
     // A Subscriber allows an application to create one or more DataReaders
     // Subscriber QoS is configured in USER_QOS_PROFILES.xml
     dds::sub::Subscriber subscriber(participant);
 
+    // Consumers that only need the recent temperature of each sensor (such
+    // as dashboards) can ask for less data. The filters apply per sensor,
+    // since each sensor_id is a separate instance:
+    //   - --min-separation: a time-based filter delivers at most one sample
+    //     of each sensor per period. When it can, the DataWriter applies
+    //     the filter itself and does not send the other samples.
+    //   - --latest-only: the DataReader keeps only the last sample of each
+    //     sensor, and the application reads them periodically instead of
+    //     being woken up by every sample.
+    dds::sub::qos::DataReaderQos reader_qos =
+            qos_provider.datareader_qos(qos_profile);
+    if (min_separation_ms > 0) {
+        reader_qos << dds::core::policy::TimeBasedFilter(
+                dds::core::Duration::from_millisecs(min_separation_ms));
+    }
+    if (latest_only) {
+        reader_qos << dds::core::policy::History::KeepLast(1);
+    }
+
     // This DataReader reads data of type Temperature on Topic
     // "ChocolateTemperature". DataReader QoS is configured in
     // USER_QOS_PROFILES.xml
-    dds::sub::DataReader<Temperature> reader(subscriber, topic);
+    dds::sub::DataReader<Temperature> reader(
+            subscriber,
+            topic_description,
+            reader_qos);
 
     // Obtain the DataReader's Status Condition
     dds::core::cond::StatusCondition status_condition(reader);
@@ -68,23 +346,284 @@ void run_example(unsigned int domain_id, unsigned int sample_count)
 
     // Associate a handler with the status condition. This will run when the
     // condition is triggered, in the context of the dispatch call (see below)
+    // With --workers, the handler only takes the samples and hands them to
+    // the workers. Each worker keeps the statistics of its own sensors.
+    std::vector<std::chrono::seconds> windows(
+            stats_windows.begin(),
+            stats_windows.end());
+    std::vector<std::unique_ptr<WorkerStatistics>> statistics;
+    for (unsigned int i = 0; i < std::max(1u, worker_count); i++) {
+        statistics.push_back(std::unique_ptr<WorkerStatistics>(
+                new WorkerStatistics(
+                        windows,
+                        std::chrono::seconds(stats_period),
+                        query_workers > 0)));
+    }
+    std::unique_ptr<WorkerPool<Temperature>> workers;
+    if (worker_count > 0) {
+        workers.reset(new WorkerPool<Temperature>(
+                worker_count,
+                [&statistics](unsigned int worker, const Temperature& data) {
+                    process_sample(data, *statistics[worker]);
+                }));
+    }
+    BatchSummary batch_summary(
+            MAX_TEMPERING_DEGREES,
+            HISTOGRAM_FIRST_DEGREES,
+            HISTOGRAM_BUCKETS);
+    // The latency is recorded when the samples are taken, before they are
+    // handed to the workers
+    std::chrono::seconds report_period(stats_period);
+    LatencyStatistics latency(report_period);
+    // The latest reading of each sensor, for other threads to read without
+    // locks (here, the metrics exporter). It is always updated by the thread
+    // taking the samples, even with --workers.
+    LastValueCache last_values(MAX_CACHED_SENSORS);
+    // With --history, the recent readings of each sensor are kept in
+    // memory, compressed. The query workers read them from their own
+    // threads, under history_mutex.
+    std::unique_ptr<TemperatureHistory> history;
+    std::mutex history_mutex;
+    if (history_seconds > 0) {
+        history.reset(new TemperatureHistory(history_seconds * 1000000000LL));
+    }
+    // With --record, the samples are also appended to a binary log as they
+    // are taken, with their timestamps, for later analysis or replay
+    std::unique_ptr<SampleLogWriter> recorder;
+    if (!record_directory.empty()) {
+        recorder.reset(new SampleLogWriter(
+                record_directory,
+                static_cast<uint64_t>(segment_size_mb) * 1024 * 1024));
+    }
     unsigned int samples_read = 0;
-    status_condition.extensions().handler([&reader, &samples_read]() {
-        samples_read += process_data(reader);
-    });
+    auto take_samples = [&reader,
+                         &batch_summary,
+                         &statistics,
+                         &latency,
+                         &last_values,
+                         &history,
+                         &history_mutex,
+                         &recorder,
+                         &workers,
+                         &samples_read]() {
+        // Locked once for all the samples taken, not for each one
+        std::unique_lock<std::mutex> history_lock(
+                history_mutex,
+                std::defer_lock);
+        if (history) {
+            history_lock.lock();
+        }
+        samples_read += process_data(
+                reader,
+                batch_summary,
+                *statistics[0],
+                latency,
+                last_values,
+                history.get(),
+                recorder.get(),
+                workers.get());
+    };
+    status_condition.extensions().handler(take_samples);
+
+    // The DataReader statuses are read each time the metrics are exported
+    MetricsExporter exporter(metrics(), metrics_file, metrics_port);
+    exporter.add(
+            "temperature_samples_lost_total",
+            "Samples lost before they reached the DataReader",
+            "counter",
+            [&reader]() { return reader.sample_lost_status().total_count(); });
+    exporter.add(
+            "temperature_samples_rejected_total",
+            "Samples the DataReader rejected for lack of resources",
+            "counter",
+            [&reader]() {
+                return reader.sample_rejected_status().total_count();
+            });
+    exporter.add(
+            "temperature_received_bytes_total",
+            "Bytes of samples received by the DataReader",
+            "counter",
+            [&reader]() {
+                return reader.extensions()
+                        .datareader_protocol_status()
+                        .received_sample_bytes();
+            });
+    exporter.add(
+            "temperature_reader_cache_samples",
+            "Samples in the DataReader queue",
+            "gauge",
+            [&reader]() {
+                return reader.extensions()
+                        .datareader_cache_status()
+                        .sample_count();
+            });
+    exporter.add(
+            "temperature_matched_publications",
+            "DataWriters matched with the DataReader",
+            "gauge",
+            [&reader]() {
+                return reader.subscription_matched_status().current_count();
+            });
+    exporter.add(
+            "temperature_cached_sensors",
+            "Sensors in the last-value cache",
+            "gauge",
+            [&last_values]() { return last_values.sensor_count(); });
+    exporter.add(
+            "temperature_hottest_sensor_degrees",
+            "Latest temperature of the hottest sensor",
+            "gauge",
+            [&last_values]() {
+                int32_t hottest = std::numeric_limits<int32_t>::min();
+                LastValueCache::Reading reading;
+                for (size_t i = 0; i < last_values.sensor_count(); i++) {
+                    last_values.read(i, reading);
+                    hottest = std::max(hottest, reading.degrees);
+                }
+                return last_values.sensor_count() > 0 ? hottest : 0;
+            });
+    exporter.start();
+
+    // With --query-workers, other applications can ask for the latest
+    // readings and the statistics of any sensors with the TemperatureQuery
+    // service, and for the --history of one sensor. The statistics of a
+    // sensor are kept by the worker its samples are sent to.
+    std::unique_ptr<TemperatureQueryService> query_service;
+    if (query_workers > 0) {
+        auto window_statistics = [&statistics](
+                                         const std::string& sensor_id,
+                                         std::chrono::seconds window,
+                                         RollingStatistics::Summary& summary) {
+            size_t worker =
+                    std::hash<std::string>()(sensor_id) % statistics.size();
+            WorkerStatistics& worker_statistics = *statistics[worker];
+            std::shared_ptr<const WorkerStatistics::Summaries> published;
+            {
+                std::lock_guard<std::mutex> lock(
+                        worker_statistics.published_mutex);
+                published = worker_statistics.published;
+            }
+            const auto& windows = worker_statistics.statistics.windows();
+            auto window_index =
+                    std::find(windows.begin(), windows.end(), window);
+            if (!published || window_index == windows.end()) {
+                return false;
+            }
+            auto found = published->find(sensor_id);
+            if (found == published->end()) {
+                return false;
+            }
+            summary = found->second[window_index - windows.begin()];
+            return true;
+        };
+        TemperatureQueryService::HistoryReadings history_readings;
+        if (history) {
+            history_readings =
+                    [&participant, &history, &history_mutex](
+                            const std::string& sensor_id,
+                            std::chrono::seconds window,
+                            std::function<void(int64_t, int32_t)> reader) {
+                        int64_t since_ns =
+                                time_ns(participant.current_time())
+                                - std::chrono::duration_cast<
+                                          std::chrono::nanoseconds>(window)
+                                          .count();
+                        std::lock_guard<std::mutex> lock(history_mutex);
+                        history->read(sensor_id, since_ns, reader);
+                        return true;
+                    };
+        }
+        query_service.reset(new TemperatureQueryService(
+                participant,
+                TEMPERATURE_QUERY_PROFILE,
+                query_workers,
+                last_values,
+                stats_windows,
+                window_statistics,
+                history_readings));
+    }
 
     // Create a WaitSet and attach the StatusCondition
     dds::core::cond::WaitSet waitset;
     waitset += status_condition;
+    waitset += shutdown_condition();  // Wakes it up on control-C
 
+    // Compare the CPU time used with and without --min-separation,
+    // --latest-only and --filter, with the same publisher (e.g. --rate
+    // 10000)
+    double start_cpu = process_cpu_seconds();
+    auto start_time = std::chrono::steady_clock::now();
+    dds::core::Duration latest_value_period =
+            dds::core::Duration::from_millisecs(
+                    min_separation_ms > 0 ? min_separation_ms
+                                          : LATEST_VALUE_PERIOD_MS);
+    // With --latest-only, waits for the next period; only control-C ends
+    // the wait early
+    dds::core::cond::WaitSet shutdown_waitset;
+    shutdown_waitset += shutdown_condition();
     while (running && (samples_read < sample_count || sample_count == 0)) {
+        if (history) {
+            // Also drops the sensors that stopped sending, even when no
+            // samples arrive
+            std::lock_guard<std::mutex> lock(history_mutex);
+            history->expire(time_ns(participant.current_time()));
+        }
+        if (latest_only) {
+            shutdown_waitset.wait(latest_value_period);
+            take_samples();
+            continue;
+        }
+
         // Dispatch will call the handlers associated to the WaitSet conditions
         // when they activate
-        std::cout << "ChocolateTemperature subscriber sleeping for 4 sec..."
-                  << std::endl;
+        console.print("ChocolateTemperature subscriber sleeping for 4 sec...");
 
         waitset.dispatch(dds::core::Duration(4));  // Wait up to 4s each time
     }
+
+    if (query_service) {
+        query_service->stop();
+    }
+    if (workers) {
+        // Finish processing the samples already taken
+        workers->stop();
+    }
+    console.stop();  // Print the queued lines before the summary
+    auto now = RollingStatistics::clock::now();
+    for (auto& worker_statistics : statistics) {
+        print_statistics(worker_statistics->statistics, now);
+    }
+    batch_summary.print(std::cout);
+    print_latency(latency, now, std::numeric_limits<size_t>::max());
+    if (workers) {
+        workers->print_utilization(std::cout);
+    }
+    if (query_service) {
+        query_service->print_utilization(std::cout);
+    }
+
+    std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start_time;
+    double cpu_seconds = process_cpu_seconds() - start_cpu;
+    std::cout << "Took " << samples_read << " samples in " << elapsed.count()
+              << " s, using " << cpu_seconds << " s of CPU ("
+              << (elapsed.count() > 0 ? 100 * cpu_seconds / elapsed.count()
+                                      : 0)
+              << "% of one core)" << std::endl;
+    auto protocol_status = reader.extensions().datareader_protocol_status();
+    std::cout << "Received " << protocol_status.received_sample_count()
+              << " samples (" << protocol_status.received_sample_bytes()
+              << " bytes)" << std::endl;
+    print_last_values(last_values, std::cout);
+    if (history) {
+        history->print_summary(std::cout);
+    }
+    if (recorder) {
+        std::cout << "Recorded " << recorder->record_count() << " samples ("
+                  << recorder->byte_count() << " bytes) in "
+                  << recorder->segment_count() << " segments in "
+                  << record_directory << std::endl;
+    }
 }
 
 // Sets Connext verbosity to help debugging
@@ -106,16 +645,35 @@ int main(int argc, char *argv[])
 
     // Enables different levels of debugging output
     set_verbosity(arguments.verbosity);
+    console.start(arguments.output_mode);
 
     try {
-        run_example(arguments.domain_id, arguments.sample_count);
+        run_example(
+                arguments.domain_id,
+                arguments.sample_count,
+                arguments.workers,
+                arguments.stats_period,
+                arguments.stats_windows,
+                arguments.min_separation_ms,
+                arguments.latest_only,
+                arguments.filter,
+                arguments.history_seconds,
+                arguments.record_directory,
+                arguments.segment_size_mb,
+                arguments.query_workers,
+                arguments.metrics_file,
+                arguments.metrics_port,
+                arguments.qos_profile);
     } catch (const std::exception& ex) {
         // All DDS exceptions inherit from std::exception
         std::cerr << "Exception in subscriber_main(): " << ex.what()
                   << std::endl;
+        teardown_signal_handlers();
         return EXIT_FAILURE;
     }
 
+    teardown_signal_handlers();
+
     // Releases the memory used by the participant factory.  Optional at
     // application shutdown
     dds::domain::DomainParticipant::finalize_participant_factory();
@@ -0,0 +1,282 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+// Throughput benchmark, publishing side. For each combination of payload
+// size, batch size and DataWriter history depth, writes temperature samples
+// as fast as reliable flow control allows for --duration seconds, and
+// prints the samples and bytes written per second and the CPU time used per
+// sample. Run temperature_throughput_sub first: it reports what was
+// received, and the samples lost, for the same runs.
+//
+//   temperature_throughput_pub [--payload-sizes <B,...>]
+//                              [--batch-sizes <samples,...>]
+//                              [--history-depths <samples,...>]
+//                              [--duration <s>] [--results <file>]
+//                              [--qos-profile <profile>]
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <dds/pub/ddspub.hpp>
+#include <rti/util/util.hpp>  // for sleep()
+#include <rti/config/Logger.hpp>  // for logging
+// Or simply include <dds/dds.hpp>
+
+#include "temperature_zero_copy.hpp"  // TemperaturePayload
+#include "application.hpp"  // Argument parsing
+#include "throughput.hpp"
+
+using namespace application;
+
+// Used without --qos-profile
+const std::string DEFAULT_QOS_PROFILE =
+        "ChocolateFactoryLibrary::ThroughputTemperatureProfile";
+
+// Larger samples do not fit in one transport message, and would need
+// asynchronous publishing (see LargePayloadTemperatureProfile)
+const unsigned int MAX_THROUGHPUT_PAYLOAD_SIZE = 60000;
+
+// How long each run waits for the subscriber to acknowledge its samples
+const dds::core::Duration DRAIN_TIMEOUT(10);
+
+// Creates the DataWriter of one run, with its batch size and history depth
+dds::pub::DataWriter<TemperaturePayload> create_writer(
+        dds::pub::Publisher& publisher,
+        dds::topic::Topic<TemperaturePayload>& topic,
+        const std::string& qos_profile,
+        const RunConfig& config)
+{
+    dds::pub::qos::DataWriterQos writer_qos =
+            dds::core::QosProvider::Default().datawriter_qos(qos_profile);
+
+    // Batch size 0 disables batching, even if the profile enables it
+    rti::core::policy::Batch batch =
+            writer_qos.policy<rti::core::policy::Batch>();
+    batch.enable(config.batch_size > 0);
+    if (config.batch_size > 0) {
+        batch.max_samples(config.batch_size);
+    }
+    writer_qos << batch;
+
+    if (config.history_depth > 0) {
+        writer_qos << dds::core::policy::History::KeepLast(
+                config.history_depth);
+    } else {
+        writer_qos << dds::core::policy::History::KeepAll();
+    }
+
+    return dds::pub::DataWriter<TemperaturePayload>(
+            publisher,
+            topic,
+            writer_qos);
+}
+
+void write_control(
+        dds::pub::DataWriter<TemperaturePayload>& writer,
+        ControlPhase phase,
+        const std::string& text,
+        int64_t samples_written)
+{
+    TemperaturePayload control;
+    control.sensor_id(CONTROL_SENSOR_ID);
+    control.degrees(phase);
+    control.timestamp(samples_written);
+    control.payload().resize(text.size());
+    std::copy(text.begin(), text.end(), control.payload().begin());
+    writer.write(control);
+}
+
+// Writes samples for 'duration' seconds. Returns the row of results.
+ResultsFile::Row run(
+        dds::pub::Publisher& publisher,
+        dds::topic::Topic<TemperaturePayload>& topic,
+        const std::string& qos_profile,
+        const RunConfig& config,
+        unsigned int duration)
+{
+    dds::pub::DataWriter<TemperaturePayload> writer =
+            create_writer(publisher, topic, qos_profile, config);
+    while (running
+           && writer.publication_matched_status().current_count() == 0) {
+        rti::util::sleep(dds::core::Duration::from_millisecs(100));
+    }
+    write_control(writer, RUN_START, config.to_string(), 0);
+
+    TemperaturePayload sample;
+    sample.sensor_id(0);
+    sample.payload().resize(config.payload_size);
+
+    uint64_t count = 0;
+    double start_cpu = process_cpu_seconds();
+    auto start_time = std::chrono::steady_clock::now();
+    auto end_time = start_time + std::chrono::seconds(duration);
+    while (running) {
+        // Reading the clock for every sample would cost as much as writing
+        // a small one
+        if (count % 1000 == 0 && std::chrono::steady_clock::now() >= end_time) {
+            break;
+        }
+        sample.degrees(30 + count % 3);
+        sample.timestamp(count);
+        writer.write(sample);
+        count++;
+    }
+    // Send the last, partial batch
+    writer.extensions().flush();
+    std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start_time;
+    double cpu_seconds = process_cpu_seconds() - start_cpu;
+
+    write_control(writer, RUN_END, "", count);
+    // A subscriber that did not acknowledge everything in time does not end
+    // the sweep: the row says so
+    bool acknowledged = true;
+    try {
+        writer.wait_for_acknowledgments(DRAIN_TIMEOUT);
+    } catch (const dds::core::TimeoutError&) {
+        acknowledged = false;
+    }
+
+    double seconds = std::max(elapsed.count(), 1e-9);
+    double samples_per_second = count / seconds;
+    double mbytes_per_second = samples_per_second * config.payload_size / 1e6;
+    double cpu_ns_per_sample = count > 0 ? cpu_seconds * 1e9 / count : 0;
+    std::cout << "Run " << config.run << ": payload " << config.payload_size
+              << " B, batch " << config.batch_size << ", history "
+              << (config.history_depth > 0
+                          ? std::to_string(config.history_depth)
+                          : std::string("all"))
+              << ": " << count << " samples, " << samples_per_second
+              << " msgs/s, " << mbytes_per_second << " MB/s, "
+              << cpu_ns_per_sample << " CPU ns/sample"
+              << (acknowledged ? "" : ", not all acknowledged") << std::endl;
+
+    return { { "run", config.run },
+             { "payload_size", config.payload_size },
+             { "batch_size", config.batch_size },
+             { "history_depth", config.history_depth },
+             { "samples", static_cast<double>(count) },
+             { "samples_per_second", samples_per_second },
+             { "mbytes_per_second", mbytes_per_second },
+             { "cpu_ns_per_sample", cpu_ns_per_sample },
+             { "acknowledged", acknowledged ? 1.0 : 0.0 } };
+}  // The DataWriter is deleted, so each run starts with a new one
+
+void run_example(
+        unsigned int domain_id,
+        const std::vector<unsigned int>& payload_sizes,
+        const std::vector<unsigned int>& batch_sizes,
+        const std::vector<unsigned int>& history_depths,
+        unsigned int duration,
+        const std::string& results_file,
+        std::string qos_profile)
+{
+    if (qos_profile.empty()) {
+        qos_profile = DEFAULT_QOS_PROFILE;
+    }
+    dds::core::QosProvider qos_provider = dds::core::QosProvider::Default();
+    dds::domain::DomainParticipant participant(
+            domain_id,
+            qos_provider.participant_qos(qos_profile));
+    dds::topic::Topic<TemperaturePayload> topic(
+            participant,
+            "ChocolateTemperatureThroughput");
+    // Ordered access whatever the profile (see CONTROL_SENSOR_ID)
+    dds::pub::qos::PublisherQos publisher_qos =
+            qos_provider.publisher_qos(qos_profile);
+    publisher_qos << dds::core::policy::Presentation::TopicAccessScope(
+            false,
+            true);
+    dds::pub::Publisher publisher(participant, publisher_qos);
+
+    ResultsFile results(results_file);
+    std::cout << "Waiting for temperature_throughput_sub..." << std::endl;
+    unsigned int run_number = 0;
+    for (unsigned int payload_size : payload_sizes) {
+        for (unsigned int batch_size : batch_sizes) {
+            for (unsigned int history_depth : history_depths) {
+                if (!running) {
+                    break;
+                }
+                RunConfig config = {
+                    ++run_number,
+                    std::min(payload_size, MAX_THROUGHPUT_PAYLOAD_SIZE),
+                    batch_size,
+                    history_depth
+                };
+                results.add(
+                        run(publisher, topic, qos_profile, config, duration));
+
+                // Give the subscriber a clear gap between runs
+                rti::util::sleep(dds::core::Duration(1));
+            }
+        }
+    }
+
+    if (running) {
+        dds::pub::DataWriter<TemperaturePayload> writer(
+                publisher,
+                topic,
+                qos_provider.datawriter_qos(qos_profile));
+        write_control(writer, SWEEP_END, "", 0);
+        wait_for_acknowledgments_on_exit(writer);
+    }
+}
+
+// Sets Connext verbosity to help debugging
+void set_verbosity(rti::config::Verbosity verbosity)
+{
+    rti::config::Logger::instance().verbosity(verbosity);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::PARSE_RETURN_EXIT) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::PARSE_RETURN_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Enables different levels of debugging output
+    set_verbosity(arguments.verbosity);
+
+    try {
+        run_example(
+                arguments.domain_id,
+                arguments.payload_sizes,
+                arguments.batch_sizes,
+                arguments.history_depths,
+                arguments.duration,
+                arguments.results_file,
+                arguments.qos_profile);
+    } catch (const std::exception& ex) {
+        // This will catch DDS exceptions
+        std::cerr << "Exception in publisher_main(): " << ex.what()
+                  << std::endl;
+        teardown_signal_handlers();
+        return EXIT_FAILURE;
+    }
+
+    teardown_signal_handlers();
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
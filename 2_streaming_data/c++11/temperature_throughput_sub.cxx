@@ -0,0 +1,257 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+// Throughput benchmark, subscribing side. For each run of
+// temperature_throughput_pub, prints the samples and bytes received per
+// second, the samples lost and the CPU time used per sample. Exits when the
+// publisher has finished all its runs.
+//
+//   temperature_throughput_sub [--results <file>] [--qos-profile <profile>]
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include <dds/sub/ddssub.hpp>
+#include <dds/core/ddscore.hpp>
+#include <rti/config/Logger.hpp>  // for logging
+// Or simply include <dds/dds.hpp>
+
+#include "temperature_zero_copy.hpp"  // TemperaturePayload
+#include "application.hpp"  // Argument parsing
+#include "throughput.hpp"
+
+using namespace application;
+
+// Used without --qos-profile
+const std::string DEFAULT_QOS_PROFILE =
+        "ChocolateFactoryLibrary::ThroughputTemperatureProfile";
+
+// Counts the samples of the current run, from the first data sample to the
+// RUN_END control sample
+class RunCounter {
+public:
+    explicit RunCounter(ResultsFile& results)
+            : results_(results),
+              in_run_(false),
+              sweep_ended_(false),
+              samples_(0),
+              bytes_(0),
+              start_cpu_(0)
+    {
+        config_ = { 0, 0, 0, 0 };
+    }
+
+    void add(const TemperaturePayload& sample)
+    {
+        if (sample.sensor_id() == CONTROL_SENSOR_ID) {
+            control(sample);
+            return;
+        }
+
+        if (samples_ == 0) {
+            start_time_ = std::chrono::steady_clock::now();
+            start_cpu_ = process_cpu_seconds();
+        }
+        samples_++;
+        bytes_ += sample.payload().size();
+    }
+
+    bool sweep_ended() const
+    {
+        return sweep_ended_;
+    }
+
+private:
+    void control(const TemperaturePayload& sample)
+    {
+        switch (sample.degrees()) {
+        case RUN_START:
+            config_ = RunConfig::from_string(std::string(
+                    sample.payload().begin(),
+                    sample.payload().end()));
+            in_run_ = true;
+            samples_ = 0;
+            bytes_ = 0;
+            break;
+        case RUN_END:
+            if (in_run_) {
+                end_run(static_cast<uint64_t>(sample.timestamp()));
+            }
+            in_run_ = false;
+            break;
+        case SWEEP_END:
+            sweep_ended_ = true;
+            break;
+        }
+    }
+
+    void end_run(uint64_t samples_sent)
+    {
+        // The time from the first to the last sample; the publisher writes
+        // for as long, but its first sample arrives a little later
+        std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - start_time_;
+        double cpu_seconds =
+                samples_ > 0 ? process_cpu_seconds() - start_cpu_ : 0;
+
+        double seconds = std::max(elapsed.count(), 1e-9);
+        double samples_per_second = samples_ > 0 ? samples_ / seconds : 0;
+        double mbytes_per_second = samples_ > 0 ? bytes_ / seconds / 1e6 : 0;
+        // With a KEEP_LAST DataWriter history, samples the DataReader has
+        // not acknowledged yet can be replaced by newer ones
+        uint64_t lost = samples_sent - std::min(samples_sent, samples_);
+        double cpu_ns_per_sample =
+                samples_ > 0 ? cpu_seconds * 1e9 / samples_ : 0;
+
+        std::cout << "Run " << config_.run << ": payload "
+                  << config_.payload_size << " B, batch "
+                  << config_.batch_size << ", history "
+                  << (config_.history_depth > 0
+                              ? std::to_string(config_.history_depth)
+                              : std::string("all"))
+                  << ": " << samples_ << " samples, " << samples_per_second
+                  << " msgs/s, " << mbytes_per_second << " MB/s, " << lost
+                  << " lost, " << cpu_ns_per_sample << " CPU ns/sample"
+                  << std::endl;
+
+        results_.add(
+                { { "run", config_.run },
+                  { "payload_size", config_.payload_size },
+                  { "batch_size", config_.batch_size },
+                  { "history_depth", config_.history_depth },
+                  { "samples_sent", static_cast<double>(samples_sent) },
+                  { "samples_received", static_cast<double>(samples_) },
+                  { "samples_lost", static_cast<double>(lost) },
+                  { "samples_per_second", samples_per_second },
+                  { "mbytes_per_second", mbytes_per_second },
+                  { "cpu_ns_per_sample", cpu_ns_per_sample } });
+    }
+
+    ResultsFile& results_;
+    RunConfig config_;
+    bool in_run_;
+    bool sweep_ended_;
+    uint64_t samples_;
+    uint64_t bytes_;
+    std::chrono::steady_clock::time_point start_time_;
+    double start_cpu_;
+};
+
+void process_data(
+        dds::sub::DataReader<TemperaturePayload>& reader,
+        RunCounter& counter)
+{
+    // Take all samples.  Samples are loaned to application, loan is
+    // returned when LoanedSamples destructor called.
+    dds::sub::LoanedSamples<TemperaturePayload> samples = reader.take();
+    for (const auto& sample : samples) {
+        if (sample.info().valid()) {
+            counter.add(sample.data());
+        }
+    }
+}  // The LoanedSamples destructor returns the loan
+
+void run_example(
+        unsigned int domain_id,
+        const std::string& results_file,
+        std::string qos_profile)
+{
+    if (qos_profile.empty()) {
+        qos_profile = DEFAULT_QOS_PROFILE;
+    }
+    dds::core::QosProvider qos_provider = dds::core::QosProvider::Default();
+    dds::domain::DomainParticipant participant(
+            domain_id,
+            qos_provider.participant_qos(qos_profile));
+    dds::topic::Topic<TemperaturePayload> topic(
+            participant,
+            "ChocolateTemperatureThroughput");
+    // The DataReader keeps all samples (KEEP_ALL history) whatever the
+    // profile, so only the DataWriter history depth of each run decides
+    // what can be lost
+    dds::sub::qos::DataReaderQos reader_qos =
+            qos_provider.datareader_qos(qos_profile);
+    reader_qos << dds::core::policy::History::KeepAll();
+    // Without ordered access, the RUN_END control sample could be taken
+    // before the last samples of its run (see CONTROL_SENSOR_ID)
+    dds::sub::qos::SubscriberQos subscriber_qos =
+            qos_provider.subscriber_qos(qos_profile);
+    subscriber_qos << dds::core::policy::Presentation::TopicAccessScope(
+            false,
+            true);
+    dds::sub::DataReader<TemperaturePayload> reader(
+            dds::sub::Subscriber(participant, subscriber_qos),
+            topic,
+            reader_qos);
+
+    ResultsFile results(results_file);
+    RunCounter counter(results);
+    dds::core::cond::StatusCondition status_condition(reader);
+    status_condition.enabled_statuses(
+            dds::core::status::StatusMask::data_available());
+    status_condition.extensions().handler([&reader, &counter]() {
+        process_data(reader, counter);
+    });
+
+    dds::core::cond::WaitSet waitset;
+    waitset += status_condition;
+    waitset += shutdown_condition();  // Wakes it up on control-C
+
+    std::cout << "Waiting for temperature_throughput_pub..." << std::endl;
+    while (running && !counter.sweep_ended()) {
+        waitset.dispatch(dds::core::Duration(4));  // Wait up to 4s each time
+    }
+}
+
+// Sets Connext verbosity to help debugging
+void set_verbosity(rti::config::Verbosity verbosity)
+{
+    rti::config::Logger::instance().verbosity(verbosity);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::PARSE_RETURN_EXIT) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::PARSE_RETURN_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Enables different levels of debugging output
+    set_verbosity(arguments.verbosity);
+
+    try {
+        run_example(
+                arguments.domain_id,
+                arguments.results_file,
+                arguments.qos_profile);
+    } catch (const std::exception& ex) {
+        // All DDS exceptions inherit from std::exception
+        std::cerr << "Exception in subscriber_main(): " << ex.what()
+                  << std::endl;
+        teardown_signal_handlers();
+        return EXIT_FAILURE;
+    }
+
+    teardown_signal_handlers();
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,120 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef TEMPERATURE_WRITER_HPP
+#define TEMPERATURE_WRITER_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+#include <dds/pub/ddspub.hpp>
+#include <rti/pub/FlowController.hpp>
+
+#include "temperature.hpp"
+
+// The DataWriter setup shared by temperature_publisher and
+// temperature_replay
+
+namespace application {
+
+// Name of the flow controller created for --flow-rate
+const std::string FLOW_CONTROLLER_NAME = "TemperatureFlowController";
+
+// The profile used without --qos-profile: the default profile, or the
+// profile tuned for asynchronous publishing or batching when they are
+// requested
+inline std::string default_writer_profile(
+        bool async_publish,
+        unsigned int batch_size)
+{
+    if (async_publish) {
+        return "ChocolateFactoryLibrary::AsynchronousTemperatureProfile";
+    } else if (batch_size > 0) {
+        return "ChocolateFactoryLibrary::BatchingTemperatureProfile";
+    } else {
+        return "ChocolateFactoryLibrary::TemperingTemperatureProfile";
+    }
+}
+
+// Creates a token-bucket flow controller that lets 'rate' bytes per second
+// through, in bursts of up to 'burst' bytes. Each token lets 256 bytes
+// through (a smaller sample still takes a whole token), and tokens are
+// added every 10 ms, or less often for rates under 25.6 KB/s.
+inline rti::pub::FlowController create_flow_controller(
+        dds::domain::DomainParticipant& participant,
+        unsigned int rate,
+        unsigned int burst)
+{
+    const int32_t bytes_per_token = 256;
+    int64_t period_ms = std::max<int64_t>(
+            10,
+            (1000LL * bytes_per_token + rate - 1) / rate);
+    int32_t tokens_per_period = static_cast<int32_t>(std::max<int64_t>(
+            1,
+            rate * period_ms / 1000 / bytes_per_token));
+    int32_t max_tokens = std::max<int32_t>(
+            tokens_per_period,
+            burst / bytes_per_token);
+    rti::pub::FlowControllerTokenBucketProperty token_bucket(
+            max_tokens,
+            tokens_per_period,
+            0,  // Tokens leaked per period: unused tokens are kept
+            dds::core::Duration::from_millisecs(period_ms),
+            bytes_per_token);
+    return rti::pub::FlowController(
+            participant,
+            FLOW_CONTROLLER_NAME,
+            rti::pub::FlowControllerProperty(
+                    rti::pub::FlowControllerSchedulingPolicy::
+                            EARLIEST_DEADLINE_FIRST,
+                    token_bucket));
+}
+
+// Creates the DataWriter with the QoS of a profile in USER_QOS_PROFILES.xml.
+// When batching is requested, batching is enabled with the batch limits
+// taken from the command line. When asynchronous publishing is requested,
+// samples are sent through the named flow controller, or through the
+// default one when the name is empty.
+inline dds::pub::DataWriter<Temperature> create_writer(
+        dds::pub::Publisher& publisher,
+        dds::topic::Topic<Temperature>& topic,
+        const std::string& qos_profile,
+        unsigned int batch_size,
+        unsigned int batch_flush_us,
+        bool async_publish,
+        const std::string& flow_controller_name)
+{
+    dds::pub::qos::DataWriterQos writer_qos =
+            dds::core::QosProvider::Default().datawriter_qos(qos_profile);
+    if (batch_size > 0) {
+        rti::core::policy::Batch batch =
+                writer_qos.policy<rti::core::policy::Batch>();
+        batch.enable(true);
+        batch.max_samples(batch_size);
+        batch.max_flush_delay(
+                dds::core::Duration::from_microsecs(batch_flush_us));
+        writer_qos << batch;
+    }
+    if (async_publish) {
+        writer_qos << (flow_controller_name.empty()
+                               ? rti::core::policy::PublishMode::Asynchronous()
+                               : rti::core::policy::PublishMode::Asynchronous(
+                                       flow_controller_name));
+    }
+
+    return dds::pub::DataWriter<Temperature>(publisher, topic, writer_qos);
+}
+
+}  // namespace application
+
+#endif  // TEMPERATURE_WRITER_HPP
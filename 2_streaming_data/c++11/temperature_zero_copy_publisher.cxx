@@ -0,0 +1,312 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+// Compares Zero Copy transfer over shared memory (--zero-copy) with the usual
+// copy path. For each payload size from 16 B to 1 MB (or only
+// --payload-size), writes --sample-count samples at --rate samples per second
+// (as fast as possible by default). Run temperature_zero_copy_subscriber on
+// the same host, with the same --zero-copy setting, to see the latency and
+// throughput of each payload size.
+//
+// The copy path writes the payloads that fit in one transport message
+// synchronously, and only the larger ones, which are sent in fragments,
+// asynchronously. Each line of output says which one was used.
+//
+// Zero Copy transfer requires linking with the nddsmetp library.
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <dds/pub/ddspub.hpp>
+#include <rti/util/util.hpp>  // for sleep()
+#include <rti/config/Logger.hpp>  // for logging
+// Or simply include <dds/dds.hpp>
+
+#include "temperature_zero_copy.hpp"
+#include "application.hpp"  // Argument parsing
+
+using namespace application;
+
+const unsigned int DEFAULT_SAMPLES_PER_SIZE = 1000;
+const dds::core::Duration DRAIN_TIMEOUT(10);
+
+// Larger payloads do not fit in one shared memory message with the rest of
+// the sample, so they are sent in fragments
+const uint32_t MAX_UNFRAGMENTED_PAYLOAD_SIZE = 60000;
+
+// Monotonic time in nanoseconds. On Linux, steady_clock uses
+// CLOCK_MONOTONIC, which all processes on the host share.
+int64_t monotonic_now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+}
+
+// Writes one sample with a given payload size. Specialized below for each
+// of the two data types.
+template <typename T>
+class PayloadWriter;
+
+// Zero copy: each sample is loaned from the DataWriter's pool in shared
+// memory and filled in place. write() only sends a reference to it.
+template <>
+class PayloadWriter<TemperatureZeroCopy> {
+public:
+    explicit PayloadWriter(dds::pub::DataWriter<TemperatureZeroCopy> writer)
+            : writer_(writer)
+    {
+    }
+
+    void write(uint32_t payload_length, int32_t degrees)
+    {
+        TemperatureZeroCopy *sample = writer_.extensions().get_loan();
+        sample->sensor_id(0);
+        sample->degrees(degrees);
+        sample->payload_length(payload_length);
+        sample->timestamp(monotonic_now_ns());
+        writer_.write(*sample);
+    }
+
+    dds::pub::DataWriter<TemperatureZeroCopy>& writer()
+    {
+        return writer_;
+    }
+
+private:
+    dds::pub::DataWriter<TemperatureZeroCopy> writer_;
+};
+
+// Copy path: one sample is reused for all writes. write() serializes it,
+// so its cost grows with the payload size.
+template <>
+class PayloadWriter<TemperaturePayload> {
+public:
+    explicit PayloadWriter(dds::pub::DataWriter<TemperaturePayload> writer)
+            : writer_(writer)
+    {
+    }
+
+    void write(uint32_t payload_length, int32_t degrees)
+    {
+        sample_.sensor_id(0);
+        sample_.degrees(degrees);
+        sample_.payload().resize(payload_length);
+        sample_.timestamp(monotonic_now_ns());
+        writer_.write(sample_);
+    }
+
+    dds::pub::DataWriter<TemperaturePayload>& writer()
+    {
+        return writer_;
+    }
+
+private:
+    dds::pub::DataWriter<TemperaturePayload> writer_;
+    TemperaturePayload sample_;
+};
+
+template <typename T>
+bool is_matched(PayloadWriter<T>& payload_writer)
+{
+    return payload_writer.writer().publication_matched_status().current_count()
+            > 0;
+}
+
+// Publishes the payloads that fit in one transport message with the
+// DataWriter of qos_profile, and the larger ones with the DataWriter of
+// fragmented_qos_profile. With Zero Copy only a reference to the sample is
+// sent, so both profiles are the same and there is only one DataWriter.
+template <typename T>
+void publish(
+        unsigned int domain_id,
+        const std::string& qos_profile,
+        const std::string& fragmented_qos_profile,
+        const std::string& topic_name,
+        unsigned int samples_per_size,
+        double rate,
+        unsigned int payload_size)
+{
+    dds::core::QosProvider qos_provider = dds::core::QosProvider::Default();
+
+    // All the profiles limit the DomainParticipant to the shared memory
+    // transport
+    dds::domain::DomainParticipant participant(
+            domain_id,
+            qos_provider.participant_qos(fragmented_qos_profile));
+    dds::topic::Topic<T> topic(participant, topic_name);
+    dds::pub::Publisher publisher(participant);
+    PayloadWriter<T> payload_writer(dds::pub::DataWriter<T>(
+            publisher,
+            topic,
+            qos_provider.datawriter_qos(qos_profile)));
+    std::unique_ptr<PayloadWriter<T>> fragmented_writer;
+    if (fragmented_qos_profile != qos_profile) {
+        fragmented_writer.reset(new PayloadWriter<T>(dds::pub::DataWriter<T>(
+                publisher,
+                topic,
+                qos_provider.datawriter_qos(fragmented_qos_profile))));
+    }
+
+    // Powers of 4 from 16 B to 1 MB, unless a size is given
+    std::vector<uint32_t> payload_sizes;
+    if (payload_size > 0) {
+        payload_sizes.push_back(std::min(payload_size, MAX_PAYLOAD_SIZE));
+    } else {
+        for (uint32_t size = 16; size <= MAX_PAYLOAD_SIZE; size *= 4) {
+            payload_sizes.push_back(size);
+        }
+    }
+
+    std::cout << "Waiting for a subscriber..." << std::endl;
+    while (running
+           && (!is_matched(payload_writer)
+               || (fragmented_writer && !is_matched(*fragmented_writer)))) {
+        rti::util::sleep(dds::core::Duration::from_millisecs(100));
+    }
+
+    for (uint32_t size : payload_sizes) {
+        if (!running) {
+            break;
+        }
+
+        bool fragmented = fragmented_writer
+                && size > MAX_UNFRAGMENTED_PAYLOAD_SIZE;
+        PayloadWriter<T>& size_writer =
+                fragmented ? *fragmented_writer : payload_writer;
+        dds::pub::DataWriter<T>& writer = size_writer.writer();
+
+        RateScheduler scheduler(rate);
+        std::chrono::steady_clock::duration write_time(0);
+        auto start_time = std::chrono::steady_clock::now();
+        unsigned int count = 0;
+        for (; running && count < samples_per_size; count++) {
+            if (!scheduler.wait()) {
+                break;  // Control-C
+            }
+            auto write_start = std::chrono::steady_clock::now();
+            size_writer.write(size, 30 + count % 3);
+            write_time += std::chrono::steady_clock::now() - write_start;
+        }
+        auto end_time = std::chrono::steady_clock::now();
+
+        // Waits until the subscriber has every sample before the next size.
+        // The wait is not part of the rate written.
+        bool acknowledged = true;
+        try {
+            writer.wait_for_acknowledgments(DRAIN_TIMEOUT);
+        } catch (const dds::core::TimeoutError&) {
+            acknowledged = false;
+        }
+        std::chrono::duration<double> elapsed = end_time - start_time;
+        std::chrono::duration<double> drain_time =
+                std::chrono::steady_clock::now() - end_time;
+
+        std::cout << "Payload " << size << " B ("
+                  << (fragmented ? "asynchronous" : "synchronous")
+                  << "): " << count << " samples, "
+                  << (elapsed.count() > 0 ? count / elapsed.count() : 0)
+                  << " msgs/s, "
+                  << std::chrono::duration<double, std::micro>(write_time)
+                                .count()
+                        / std::max(count, 1u)
+                  << " us per write(), ";
+        if (acknowledged) {
+            std::cout << drain_time.count() << " s to drain" << std::endl;
+        } else {
+            std::cout << "not all acknowledged after " << drain_time.count()
+                      << " s" << std::endl;
+        }
+
+        // Give the subscriber a clear gap between payload sizes
+        rti::util::sleep(dds::core::Duration(1));
+    }
+}
+
+void run_example(
+        unsigned int domain_id,
+        unsigned int sample_count,
+        double rate,
+        bool zero_copy,
+        unsigned int payload_size)
+{
+    if (sample_count == 0) {
+        sample_count = DEFAULT_SAMPLES_PER_SIZE;
+    }
+
+    if (zero_copy) {
+        publish<TemperatureZeroCopy>(
+                domain_id,
+                "ChocolateFactoryLibrary::ZeroCopyTemperatureProfile",
+                "ChocolateFactoryLibrary::ZeroCopyTemperatureProfile",
+                "ChocolateTemperatureZeroCopy",
+                sample_count,
+                rate,
+                payload_size);
+    } else {
+        publish<TemperaturePayload>(
+                domain_id,
+                "ChocolateFactoryLibrary::SmallPayloadTemperatureProfile",
+                "ChocolateFactoryLibrary::LargePayloadTemperatureProfile",
+                "ChocolateTemperaturePayload",
+                sample_count,
+                rate,
+                payload_size);
+    }
+}
+
+// Sets Connext verbosity to help debugging
+void set_verbosity(rti::config::Verbosity verbosity)
+{
+    rti::config::Logger::instance().verbosity(verbosity);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::PARSE_RETURN_EXIT) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::PARSE_RETURN_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Enables different levels of debugging output
+    set_verbosity(arguments.verbosity);
+
+    try {
+        run_example(
+                arguments.domain_id,
+                arguments.sample_count,
+                arguments.rate,
+                arguments.zero_copy,
+                arguments.payload_size);
+    } catch (const std::exception& ex) {
+        // This will catch DDS exceptions
+        std::cerr << "Exception in publisher_main(): " << ex.what()
+                  << std::endl;
+        teardown_signal_handlers();
+        return EXIT_FAILURE;
+    }
+
+    teardown_signal_handlers();
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,248 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+// Receives the samples of temperature_zero_copy_publisher and prints, for
+// each payload size, the one-way latency and the throughput. Run it on the
+// same host as the publisher, with the same --zero-copy setting.
+//
+// Zero Copy transfer requires linking with the nddsmetp library.
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include <dds/sub/ddssub.hpp>
+#include <dds/core/ddscore.hpp>
+#include <rti/config/Logger.hpp>  // for logging
+// Or simply include <dds/dds.hpp>
+
+#include "temperature_zero_copy.hpp"
+#include "application.hpp"  // Argument parsing
+
+using namespace application;
+
+// Monotonic time in nanoseconds. On Linux, steady_clock uses
+// CLOCK_MONOTONIC, which all processes on the host share.
+int64_t monotonic_now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+}
+
+uint32_t payload_length(const TemperatureZeroCopy& sample)
+{
+    return sample.payload_length();
+}
+
+uint32_t payload_length(const TemperaturePayload& sample)
+{
+    return static_cast<uint32_t>(sample.payload().size());
+}
+
+// With Zero Copy the sample lives in the publisher's shared memory. The
+// publisher could reuse it while this application is still reading it, so
+// the reader must check that it is still consistent after using it.
+bool is_consistent(
+        dds::sub::DataReader<TemperatureZeroCopy>& reader,
+        const rti::sub::LoanedSample<TemperatureZeroCopy>& sample)
+{
+    return reader.extensions().is_data_consistent(sample);
+}
+
+// Copied samples belong to the DataReader: they are always consistent
+bool is_consistent(
+        dds::sub::DataReader<TemperaturePayload>&,
+        const rti::sub::LoanedSample<TemperaturePayload>&)
+{
+    return true;
+}
+
+// Latency and throughput of the samples of one payload size
+class PayloadStats {
+public:
+    PayloadStats() : payload_size_(0), bytes_(0)
+    {
+    }
+
+    void add(uint32_t payload_size, int64_t latency_ns)
+    {
+        if (payload_size != payload_size_) {
+            print();
+            payload_size_ = payload_size;
+            latencies_ns_.clear();
+            bytes_ = 0;
+            start_time_ = std::chrono::steady_clock::now();
+        }
+        latencies_ns_.push_back(latency_ns);
+        bytes_ += payload_size;
+        end_time_ = std::chrono::steady_clock::now();
+    }
+
+    void print()
+    {
+        if (latencies_ns_.empty()) {
+            return;
+        }
+
+        std::sort(latencies_ns_.begin(), latencies_ns_.end());
+        std::chrono::duration<double> elapsed = end_time_ - start_time_;
+        size_t count = latencies_ns_.size();
+        std::cout << "Payload " << payload_size_ << " B: " << count
+                  << " samples, latency (us) min "
+                  << latencies_ns_.front() / 1000.0 << ", p50 "
+                  << latencies_ns_[count / 2] / 1000.0 << ", p99 "
+                  << latencies_ns_[count * 99 / 100] / 1000.0 << ", max "
+                  << latencies_ns_.back() / 1000.0;
+        if (elapsed.count() > 0) {
+            std::cout << ", " << count / elapsed.count() << " msgs/s, "
+                      << bytes_ / elapsed.count() / 1e6 << " MB/s";
+        }
+        std::cout << std::endl;
+        latencies_ns_.clear();
+    }
+
+private:
+    uint32_t payload_size_;
+    uint64_t bytes_;
+    std::vector<int64_t> latencies_ns_;
+    std::chrono::steady_clock::time_point start_time_;
+    std::chrono::steady_clock::time_point end_time_;
+};
+
+template <typename T>
+unsigned int process_data(dds::sub::DataReader<T>& reader, PayloadStats& stats)
+{
+    // Take all samples.  Samples are loaned to application, loan is
+    // returned when LoanedSamples destructor called. With Zero Copy, the
+    // loaned samples are the publisher's shared-memory buffers.
+    unsigned int samples_read = 0;
+    dds::sub::LoanedSamples<T> samples = reader.take();
+    for (const auto& sample : samples) {
+        if (sample.info().valid()) {
+            int64_t latency_ns = monotonic_now_ns() - sample.data().timestamp();
+            uint32_t size = payload_length(sample.data());
+            if (!is_consistent(reader, sample)) {
+                std::cout << "Sample was overwritten while reading it"
+                          << std::endl;
+                continue;
+            }
+            samples_read++;
+            stats.add(size, latency_ns);
+        }
+    }
+
+    return samples_read;
+}  // The LoanedSamples destructor returns the loan
+
+template <typename T>
+void subscribe(
+        unsigned int domain_id,
+        const std::string& qos_profile,
+        const std::string& topic_name,
+        unsigned int sample_count)
+{
+    dds::core::QosProvider qos_provider = dds::core::QosProvider::Default();
+
+    // Both profiles limit the DomainParticipant to the shared memory
+    // transport
+    dds::domain::DomainParticipant participant(
+            domain_id,
+            qos_provider.participant_qos(qos_profile));
+    dds::topic::Topic<T> topic(participant, topic_name);
+    dds::sub::Subscriber subscriber(participant);
+    dds::sub::DataReader<T> reader(
+            subscriber,
+            topic,
+            qos_provider.datareader_qos(qos_profile));
+
+    PayloadStats stats;
+    unsigned int samples_read = 0;
+    dds::core::cond::StatusCondition status_condition(reader);
+    status_condition.enabled_statuses(
+            dds::core::status::StatusMask::data_available());
+    status_condition.extensions().handler([&reader, &stats, &samples_read]() {
+        samples_read += process_data(reader, stats);
+    });
+
+    dds::core::cond::WaitSet waitset;
+    waitset += status_condition;
+    waitset += shutdown_condition();  // Wakes it up on control-C
+
+    while (running && (samples_read < sample_count || sample_count == 0)) {
+        waitset.dispatch(dds::core::Duration(4));  // Wait up to 4s each time
+    }
+    stats.print();
+}
+
+void run_example(
+        unsigned int domain_id,
+        unsigned int sample_count,
+        bool zero_copy)
+{
+    if (zero_copy) {
+        subscribe<TemperatureZeroCopy>(
+                domain_id,
+                "ChocolateFactoryLibrary::ZeroCopyTemperatureProfile",
+                "ChocolateTemperatureZeroCopy",
+                sample_count);
+    } else {
+        subscribe<TemperaturePayload>(
+                domain_id,
+                "ChocolateFactoryLibrary::LargePayloadTemperatureProfile",
+                "ChocolateTemperaturePayload",
+                sample_count);
+    }
+}
+
+// Sets Connext verbosity to help debugging
+void set_verbosity(rti::config::Verbosity verbosity)
+{
+    rti::config::Logger::instance().verbosity(verbosity);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::PARSE_RETURN_EXIT) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::PARSE_RETURN_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Enables different levels of debugging output
+    set_verbosity(arguments.verbosity);
+
+    try {
+        run_example(
+                arguments.domain_id,
+                arguments.sample_count,
+                arguments.zero_copy);
+    } catch (const std::exception& ex) {
+        // All DDS exceptions inherit from std::exception
+        std::cerr << "Exception in subscriber_main(): " << ex.what()
+                  << std::endl;
+        teardown_signal_handlers();
+        return EXIT_FAILURE;
+    }
+
+    teardown_signal_handlers();
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
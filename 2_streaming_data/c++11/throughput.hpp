@@ -0,0 +1,163 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef THROUGHPUT_HPP
+#define THROUGHPUT_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX  // Keep windows.h from defining min and max
+    #endif
+    #include <windows.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+// Shared by temperature_throughput_pub and temperature_throughput_sub
+
+namespace application {
+
+// The publisher tells the subscriber where each run starts and ends with
+// control samples. They use their own sensor ID, so they are a separate
+// instance that a KEEP_LAST history never replaces with data. Both programs
+// use ordered access with TOPIC scope, so that the subscriber receives the
+// control samples and the data in the order they were written.
+const uint32_t CONTROL_SENSOR_ID = 0xFFFFFFFF;
+
+// Stored in the degrees field of a control sample
+enum ControlPhase {
+    RUN_START = 1,  // A run starts; the payload holds its RunConfig
+    RUN_END = 2,    // A run ended; timestamp holds the samples written
+    SWEEP_END = 3   // No more runs
+};
+
+// One combination of the sweep
+struct RunConfig {
+    unsigned int run;
+    unsigned int payload_size;
+    unsigned int batch_size;     // 0: batching disabled
+    unsigned int history_depth;  // 0: KEEP_ALL
+
+    // As text, to send in the payload of the RUN_START sample
+    std::string to_string() const
+    {
+        std::ostringstream text;
+        text << run << " " << payload_size << " " << batch_size << " "
+             << history_depth;
+        return text.str();
+    }
+
+    static RunConfig from_string(const std::string& text)
+    {
+        RunConfig config = { 0, 0, 0, 0 };
+        std::istringstream in(text);
+        in >> config.run >> config.payload_size >> config.batch_size
+                >> config.history_depth;
+        return config;
+    }
+};
+
+// CPU time used by this process so far, in all its threads, in seconds
+inline double process_cpu_seconds()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+    ULARGE_INTEGER kernel_time, user_time;
+    kernel_time.LowPart = kernel.dwLowDateTime;
+    kernel_time.HighPart = kernel.dwHighDateTime;
+    user_time.LowPart = user.dwLowDateTime;
+    user_time.HighPart = user.dwHighDateTime;
+    // FILETIME counts 100 ns intervals
+    return (kernel_time.QuadPart + user_time.QuadPart) * 1e-7;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+            + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
+
+// Writes one row per run, as CSV or, when the file name ends in .json, as a
+// JSON array of objects. The columns are the names of the first row.
+class ResultsFile {
+public:
+    typedef std::vector<std::pair<std::string, double>> Row;
+
+    explicit ResultsFile(const std::string& file_name)
+            : json_(file_name.size() >= 5
+                    && file_name.compare(file_name.size() - 5, 5, ".json")
+                            == 0),
+              row_count_(0)
+    {
+        if (!file_name.empty()) {
+            file_.open(file_name.c_str());
+            file_.precision(10);
+            if (!file_) {
+                std::cerr << "Could not open " << file_name << std::endl;
+            }
+        }
+    }
+
+    ~ResultsFile()
+    {
+        if (file_.is_open() && json_) {
+            file_ << (row_count_ > 0 ? "\n]" : "[]") << std::endl;
+        }
+    }
+
+    void add(const Row& row)
+    {
+        if (!file_.is_open()) {
+            return;
+        }
+
+        if (json_) {
+            file_ << (row_count_ == 0 ? "[\n" : ",\n") << "  {";
+            for (size_t i = 0; i < row.size(); i++) {
+                file_ << (i > 0 ? ", " : "") << "\"" << row[i].first
+                      << "\": " << row[i].second;
+            }
+            file_ << "}";
+        } else {
+            if (row_count_ == 0) {
+                for (size_t i = 0; i < row.size(); i++) {
+                    file_ << (i > 0 ? "," : "") << row[i].first;
+                }
+                file_ << std::endl;
+            }
+            for (size_t i = 0; i < row.size(); i++) {
+                file_ << (i > 0 ? "," : "") << row[i].second;
+            }
+            file_ << std::endl;
+        }
+        file_.flush();
+        row_count_++;
+    }
+
+private:
+    bool json_;
+    std::ofstream file_;
+    unsigned int row_count_;
+};
+
+}  // namespace application
+
+#endif  // THROUGHPUT_HPP
@@ -0,0 +1,350 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef TIME_SERIES_CODEC_HPP
+#define TIME_SERIES_CODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace application {
+
+// Appends bit fields to a buffer of 64-bit words, least significant bit
+// first
+class BitWriter {
+public:
+    BitWriter() : bit_count_(0)
+    {
+    }
+
+    // Writes the low 'bits' bits of 'value' (1 to 64)
+    void write(uint64_t value, unsigned int bits)
+    {
+        if (bits < 64) {
+            value &= (static_cast<uint64_t>(1) << bits) - 1;
+        }
+        unsigned int used = bit_count_ % 64;
+        if (used == 0) {
+            words_.push_back(value);
+        } else {
+            words_.back() |= value << used;
+            if (used + bits > 64) {
+                words_.push_back(value >> (64 - used));
+            }
+        }
+        bit_count_ += bits;
+    }
+
+    uint64_t bit_count() const
+    {
+        return bit_count_;
+    }
+
+    const std::vector<uint64_t>& words() const
+    {
+        return words_;
+    }
+
+    // Releases the unused capacity, once nothing more is written
+    void shrink_to_fit()
+    {
+        words_.shrink_to_fit();
+    }
+
+    size_t memory_size() const
+    {
+        return words_.capacity() * sizeof(uint64_t);
+    }
+
+private:
+    std::vector<uint64_t> words_;
+    uint64_t bit_count_;
+};
+
+// Reads back the bit fields written by a BitWriter
+class BitReader {
+public:
+    explicit BitReader(const std::vector<uint64_t>& words)
+            : words_(words), position_(0)
+    {
+    }
+
+    uint64_t read(unsigned int bits)
+    {
+        size_t index = static_cast<size_t>(position_ / 64);
+        unsigned int used = position_ % 64;
+        uint64_t value = words_[index] >> used;
+        if (used + bits > 64) {
+            value |= words_[index + 1] << (64 - used);
+        }
+        if (bits < 64) {
+            value &= (static_cast<uint64_t>(1) << bits) - 1;
+        }
+        position_ += bits;
+        return value;
+    }
+
+    bool read_bit()
+    {
+        return read(1) != 0;
+    }
+
+private:
+    const std::vector<uint64_t>& words_;
+    uint64_t position_;
+};
+
+// Compresses a series of (timestamp, degrees) readings of one sensor, in
+// the style of the Gorilla time-series database:
+//   - timestamps as the difference between consecutive deltas (delta of
+//     delta), in units of 'resolution_ns'. Evenly spaced readings take 1
+//     bit, a jitter of a few units 9 bits.
+//   - degrees as the difference with the previous reading. An unchanged
+//     value takes 1 bit, a change of up to 2 degrees takes 4 bits.
+// The first reading is stored as is (96 bits). Timestamps are in
+// nanoseconds, and are not required to increase. They are rounded down to
+// the resolution: with the default of 1 ns the compression is lossless,
+// while a coarser resolution turns small jitter into evenly spaced
+// readings.
+class CompressedSeries {
+public:
+    explicit CompressedSeries(int64_t resolution_ns = 1)
+            : resolution_ns_(resolution_ns),
+              count_(0),
+              last_timestamp_(0),
+              last_delta_(0),
+              last_degrees_(0),
+              first_timestamp_(0)
+    {
+    }
+
+    void append(int64_t timestamp_ns, int32_t degrees)
+    {
+        int64_t timestamp = timestamp_ns / resolution_ns_;
+        if (timestamp_ns % resolution_ns_ < 0) {
+            timestamp--;  // Round negative timestamps down too
+        }
+        if (count_ == 0) {
+            bits_.write(static_cast<uint64_t>(timestamp), 64);
+            bits_.write(static_cast<uint32_t>(degrees), 32);
+            first_timestamp_ = timestamp;
+        } else {
+            int64_t delta = wrapping_subtract(timestamp, last_timestamp_);
+            write_delta_of_delta(bits_, wrapping_subtract(delta, last_delta_));
+            write_degrees_delta(
+                    bits_,
+                    static_cast<int64_t>(degrees) - last_degrees_);
+            last_delta_ = delta;
+        }
+        last_timestamp_ = timestamp;
+        last_degrees_ = degrees;
+        count_++;
+    }
+
+    // Decodes the readings in order
+    class Reader {
+    public:
+        explicit Reader(const CompressedSeries& series)
+                : bits_(series.bits_.words()),
+                  resolution_ns_(series.resolution_ns_),
+                  remaining_(series.count_),
+                  read_(0),
+                  timestamp_(0),
+                  delta_(0),
+                  degrees_(0)
+        {
+        }
+
+        // Returns false after the last reading
+        bool next(int64_t& timestamp, int32_t& degrees)
+        {
+            if (remaining_ == 0) {
+                return false;
+            }
+            if (read_ == 0) {
+                timestamp_ = static_cast<int64_t>(bits_.read(64));
+                degrees_ = static_cast<int32_t>(bits_.read(32));
+            } else {
+                delta_ = wrapping_add(delta_, read_delta_of_delta(bits_));
+                timestamp_ = wrapping_add(timestamp_, delta_);
+                degrees_ = static_cast<int32_t>(
+                        degrees_ + read_degrees_delta(bits_));
+            }
+            remaining_--;
+            read_++;
+            timestamp = timestamp_ * resolution_ns_;
+            degrees = degrees_;
+            return true;
+        }
+
+    private:
+        BitReader bits_;
+        int64_t resolution_ns_;
+        uint64_t remaining_;
+        uint64_t read_;
+        int64_t timestamp_;
+        int64_t delta_;
+        int32_t degrees_;
+    };
+
+    uint64_t size() const
+    {
+        return count_;
+    }
+
+    // In nanoseconds, rounded down to the resolution
+    int64_t first_timestamp() const
+    {
+        return first_timestamp_ * resolution_ns_;
+    }
+
+    int64_t last_timestamp() const
+    {
+        return last_timestamp_ * resolution_ns_;
+    }
+
+    // Bytes of compressed data
+    size_t compressed_size() const
+    {
+        return static_cast<size_t>((bits_.bit_count() + 7) / 8);
+    }
+
+    // Bytes allocated, including unused capacity
+    size_t memory_size() const
+    {
+        return bits_.memory_size();
+    }
+
+    // Bytes the readings take uncompressed: a 64-bit timestamp and a
+    // 32-bit value each
+    static size_t raw_size(uint64_t count)
+    {
+        return static_cast<size_t>(
+                count * (sizeof(int64_t) + sizeof(int32_t)));
+    }
+
+    // Releases the unused capacity, once nothing more is appended
+    void seal()
+    {
+        bits_.shrink_to_fit();
+    }
+
+private:
+    // Timestamps far apart overflow an int64_t difference. The difference
+    // modulo 2^64 still decodes to the right timestamp.
+    static int64_t wrapping_subtract(int64_t a, int64_t b)
+    {
+        return static_cast<int64_t>(
+                static_cast<uint64_t>(a) - static_cast<uint64_t>(b));
+    }
+
+    static int64_t wrapping_add(int64_t a, int64_t b)
+    {
+        return static_cast<int64_t>(
+                static_cast<uint64_t>(a) + static_cast<uint64_t>(b));
+    }
+
+    static uint64_t zigzag(int64_t value)
+    {
+        return (static_cast<uint64_t>(value) << 1)
+                ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    static int64_t unzigzag(uint64_t value)
+    {
+        return static_cast<int64_t>(value >> 1)
+                ^ -static_cast<int64_t>(value & 1);
+    }
+
+    // Prefix 0, 10, 110, 1110 or 1111, then a zigzag value of 0, 7, 14, 32
+    // or 64 bits
+    static void write_delta_of_delta(BitWriter& bits, int64_t delta_of_delta)
+    {
+        uint64_t value = zigzag(delta_of_delta);
+        if (value == 0) {
+            bits.write(0, 1);
+        } else if (value < (1 << 7)) {
+            bits.write(0x1, 2);
+            bits.write(value, 7);
+        } else if (value < (1 << 14)) {
+            bits.write(0x3, 3);
+            bits.write(value, 14);
+        } else if (value < (static_cast<uint64_t>(1) << 32)) {
+            bits.write(0x7, 4);
+            bits.write(value, 32);
+        } else {
+            bits.write(0xF, 4);
+            bits.write(value, 64);
+        }
+    }
+
+    static int64_t read_delta_of_delta(BitReader& bits)
+    {
+        unsigned int value_bits = 64;
+        if (!bits.read_bit()) {
+            return 0;
+        } else if (!bits.read_bit()) {
+            value_bits = 7;
+        } else if (!bits.read_bit()) {
+            value_bits = 14;
+        } else if (!bits.read_bit()) {
+            value_bits = 32;
+        }
+        return unzigzag(bits.read(value_bits));
+    }
+
+    // Prefix 0 (unchanged), 10 (a change of 1 or 2 degrees, up or down),
+    // 110 (a change that fits in 8 bits) or 111 (any change, 33 bits)
+    static void write_degrees_delta(BitWriter& bits, int64_t delta)
+    {
+        uint64_t value = zigzag(delta);
+        if (value == 0) {
+            bits.write(0, 1);
+        } else if (value <= 4) {
+            bits.write(0x1, 2);
+            bits.write(value - 1, 2);
+        } else if (value < (1 << 8)) {
+            bits.write(0x3, 3);
+            bits.write(value, 8);
+        } else {
+            bits.write(0x7, 3);
+            bits.write(static_cast<uint64_t>(delta), 33);
+        }
+    }
+
+    static int64_t read_degrees_delta(BitReader& bits)
+    {
+        if (!bits.read_bit()) {
+            return 0;
+        } else if (!bits.read_bit()) {
+            return unzigzag(bits.read(2) + 1);
+        } else if (!bits.read_bit()) {
+            return unzigzag(bits.read(8));
+        }
+        // Sign-extend the 33-bit difference
+        uint64_t value = bits.read(33);
+        return static_cast<int64_t>(value << 31) >> 31;
+    }
+
+    BitWriter bits_;
+    int64_t resolution_ns_;
+    uint64_t count_;
+    int64_t last_timestamp_;
+    int64_t last_delta_;
+    int32_t last_degrees_;
+    int64_t first_timestamp_;
+};
+
+}  // namespace application
+
+#endif  // TIME_SERIES_CODEC_HPP
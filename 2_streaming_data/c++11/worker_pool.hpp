@@ -0,0 +1,184 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace application {
+
+// A fixed set of worker threads, each with its own FIFO queue of batches.
+// Everything submitted to the same worker is processed in order, so sending
+// all the samples of a sensor to the same worker keeps them in order.
+template <typename T>
+class WorkerPool {
+public:
+    // Called with the index of the worker and the item. A worker only calls
+    // it from its own thread, so per-worker state needs no locking.
+    typedef std::function<void(unsigned int, const T&)> Handler;
+
+    // Runs 'handler' on every item submitted. submit() blocks when a worker
+    // already has max_queued_batches waiting, so a slow worker slows down
+    // the caller instead of growing its queue without limit.
+    WorkerPool(
+            unsigned int worker_count,
+            Handler handler,
+            size_t max_queued_batches = 1024)
+            : handler_(handler),
+              max_queued_batches_(max_queued_batches),
+              start_time_(std::chrono::steady_clock::now())
+    {
+        for (unsigned int i = 0; i < worker_count; i++) {
+            workers_.push_back(std::unique_ptr<Worker>(new Worker()));
+        }
+        for (unsigned int i = 0; i < worker_count; i++) {
+            workers_[i]->thread = std::thread([this, i]() { run(i); });
+        }
+    }
+
+    ~WorkerPool()
+    {
+        stop();
+    }
+
+    unsigned int worker_count() const
+    {
+        return static_cast<unsigned int>(workers_.size());
+    }
+
+    // Queues a batch for one worker. The batch is moved, not copied. Throws
+    // std::logic_error once the pool is stopping: the workers may already
+    // have exited, and the batch would never be processed.
+    void submit(unsigned int worker_index, std::vector<T>&& batch)
+    {
+        if (batch.empty()) {
+            return;
+        }
+
+        Worker& worker = *workers_[worker_index];
+        {
+            std::unique_lock<std::mutex> lock(worker.mutex);
+            worker.not_full.wait(lock, [this, &worker]() {
+                return worker.queue.size() < max_queued_batches_
+                        || worker.stopping;
+            });
+            if (worker.stopping) {
+                throw std::logic_error("WorkerPool already stopped");
+            }
+            worker.queue.push_back(std::move(batch));
+        }
+        worker.not_empty.notify_one();
+    }
+
+    // Processes everything already queued, then stops the workers
+    void stop()
+    {
+        for (auto& worker : workers_) {
+            {
+                std::lock_guard<std::mutex> lock(worker->mutex);
+                worker->stopping = true;
+            }
+            worker->not_empty.notify_one();
+            worker->not_full.notify_all();
+        }
+        for (auto& worker : workers_) {
+            if (worker->thread.joinable()) {
+                worker->thread.join();
+            }
+        }
+    }
+
+    // Prints, for each worker, the items processed and the fraction of the
+    // time it spent processing them. A pool where every worker is close to
+    // 100% needs more workers.
+    void print_utilization(std::ostream& out) const
+    {
+        std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - start_time_;
+        for (size_t i = 0; i < workers_.size(); i++) {
+            const Worker& worker = *workers_[i];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            std::chrono::duration<double> busy = worker.busy_time;
+            out << "Worker " << i << ": " << worker.processed
+                << " samples, utilization "
+                << (elapsed.count() > 0 ? 100 * busy.count() / elapsed.count()
+                                        : 0)
+                << "%, queued batches " << worker.queue.size() << std::endl;
+        }
+    }
+
+private:
+    struct Worker {
+        Worker() : stopping(false), processed(0), busy_time(0)
+        {
+        }
+
+        std::thread thread;
+        mutable std::mutex mutex;
+        std::condition_variable not_empty;
+        std::condition_variable not_full;
+        std::deque<std::vector<T>> queue;
+        bool stopping;
+        // Statistics, protected by the mutex
+        uint64_t processed;
+        std::chrono::steady_clock::duration busy_time;
+    };
+
+    void run(unsigned int worker_index)
+    {
+        Worker& worker = *workers_[worker_index];
+        std::vector<T> batch;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(worker.mutex);
+                worker.not_empty.wait(lock, [&worker]() {
+                    return !worker.queue.empty() || worker.stopping;
+                });
+                if (worker.queue.empty()) {
+                    return;  // Stopping, and nothing left to process
+                }
+                batch = std::move(worker.queue.front());
+                worker.queue.pop_front();
+            }
+            worker.not_full.notify_one();
+
+            auto start = std::chrono::steady_clock::now();
+            for (const T& item : batch) {
+                handler_(worker_index, item);
+            }
+            auto busy = std::chrono::steady_clock::now() - start;
+
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.processed += batch.size();
+            worker.busy_time += busy;
+        }
+    }
+
+    Handler handler_;
+    size_t max_queued_batches_;
+    std::chrono::steady_clock::time_point start_time_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+};
+
+}  // namespace application
+
+#endif  // WORKER_POOL_HPP
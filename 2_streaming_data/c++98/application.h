@@ -15,24 +15,136 @@
 
 #include <iostream>
 #include <csignal>
+#ifndef _WIN32
+    #include <errno.h>
+    #include <pthread.h>
+    #include <unistd.h>
+#endif
+
+#include "console_output.h"
+#include "rate_scheduler.h"
 
 namespace application {
 
-// Catch control-C and tell application to shut down
-bool running = true;
+// Catch control-C and tell application to shut down. The signal handler
+// sets it, so it is a volatile sig_atomic_t.
+volatile sig_atomic_t running = 1;
 
-inline void stop_handler(int)
+// Triggered on control-C. A loop that attaches it to its WaitSet wakes up
+// at once, instead of when its wait() times out.
+inline DDSGuardCondition *shutdown_condition()
+{
+    static DDSGuardCondition condition;
+    return &condition;
+}
+
+inline void request_shutdown()
 {
-    running = false;
     std::cout << "preparing to shut down..." << std::endl;
+    shutdown_condition()->set_trigger_value(DDS_BOOLEAN_TRUE);
+}
+
+#ifndef _WIN32
+// A signal handler may only call async-signal-safe functions, which
+// set_trigger_value() is not. It writes to this pipe instead, and a thread
+// blocked reading it calls request_shutdown().
+int shutdown_pipe[2] = { -1, -1 };
+pthread_t shutdown_thread;
+bool shutdown_thread_started = false;
+
+inline void *shutdown_thread_main(void *)
+{
+    char signal_byte;
+    ssize_t result;
+    while ((result = read(shutdown_pipe[0], &signal_byte, 1)) != 0) {
+        if (result == 1) {
+            request_shutdown();
+        } else if (errno != EINTR) {
+            break;
+        }
+    }
+    return NULL;
+}
+#endif
+
+inline void stop_handler(int)
+{
+    running = 0;
+#ifdef _WIN32
+    // Windows runs the handler in a thread of its own
+    request_shutdown();
+#else
+    char signal_byte = 0;
+    ssize_t written = write(shutdown_pipe[1], &signal_byte, 1);
+    (void) written;  // Without the pipe, loops stop at their next timeout
+#endif
 }
 
 inline void setup_signal_handlers()
 {
+    shutdown_condition();  // Created here, not in the signal path
+#ifndef _WIN32
+    if (pipe(shutdown_pipe) == 0) {
+        shutdown_thread_started = pthread_create(
+                &shutdown_thread,
+                NULL,
+                shutdown_thread_main,
+                NULL) == 0;
+    }
+#endif
     signal(SIGINT, stop_handler);
     signal(SIGTERM, stop_handler);
 }
 
+// After this, control-C only stops the loops that check 'running'
+inline void stop_running_handler(int)
+{
+    running = 0;
+}
+
+// Stops the thread that triggers shutdown_condition(). Call it before
+// finalizing the participant factory and returning from main(), so that
+// the thread does not use the condition after that.
+inline void teardown_signal_handlers()
+{
+    signal(SIGINT, stop_running_handler);
+    signal(SIGTERM, stop_running_handler);
+#ifndef _WIN32
+    if (shutdown_thread_started) {
+        // A stop_handler() already running writes to -1 and fails
+        int write_end = shutdown_pipe[1];
+        shutdown_pipe[1] = -1;
+        close(write_end);  // The thread reads the end of the pipe and exits
+        pthread_join(shutdown_thread, NULL);
+        shutdown_thread_started = false;
+        close(shutdown_pipe[0]);
+        shutdown_pipe[0] = -1;
+    }
+#endif
+}
+
+// How long a publisher waits at exit for the matched DataReaders to
+// acknowledge its last samples, which are lost if its DataWriter is deleted
+// first
+const DDS_Duration_t SHUTDOWN_ACK_TIMEOUT = { 1, 0 };
+
+// Returns false if not all the samples were acknowledged in time
+inline bool wait_for_acknowledgments_on_exit(DDSDataWriter *writer)
+{
+    DDS_ReturnCode_t retcode =
+            writer->wait_for_acknowledgments(SHUTDOWN_ACK_TIMEOUT);
+    if (retcode == DDS_RETCODE_TIMEOUT) {
+        std::cout << "Not all samples were acknowledged before shutting down"
+                  << std::endl;
+        return false;
+    } else if (retcode != DDS_RETCODE_OK) {
+        std::cerr << "wait_for_acknowledgments error " << retcode
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
 enum ParseReturn { PARSE_RETURN_OK, PARSE_RETURN_FAILURE, PARSE_RETURN_EXIT };
 
 struct ApplicationArguments {
@@ -40,6 +152,10 @@ struct ApplicationArguments {
     unsigned int domain_id;
     unsigned int sample_count;
     char sensor_id[256];
+    double rate;
+    OverrunPolicy overrun_policy;
+    unsigned int spin_us;
+    OutputMode output_mode;
     NDDS_Config_LogVerbosity verbosity;
 };
 
@@ -54,6 +170,10 @@ inline void parse_arguments(
     bool show_usage = false;
     arguments.domain_id = 0;
     arguments.sample_count = 0;  // Infinite
+    arguments.rate = 0.25;  // One sample every 4 seconds
+    arguments.overrun_policy = OVERRUN_CATCH_UP;
+    arguments.spin_us = 0;
+    arguments.output_mode = OUTPUT_SYNC;
     arguments.verbosity = NDDS_CONFIG_LOG_VERBOSITY_ERROR;
     arguments.parse_result = PARSE_RETURN_OK;
 
@@ -70,11 +190,45 @@ inline void parse_arguments(
                 || strcmp(argv[arg_processing], "--sensor-id") == 0) {
             snprintf(arguments.sensor_id, 255, "%s", argv[arg_processing + 1]);
             arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "-r") == 0
+                || strcmp(argv[arg_processing], "--rate") == 0) {
+            arguments.rate = atof(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--overrun") == 0) {
+            if (strcmp(argv[arg_processing + 1], "skip") == 0) {
+                arguments.overrun_policy = OVERRUN_SKIP;
+            } else if (strcmp(argv[arg_processing + 1], "catch-up") == 0) {
+                arguments.overrun_policy = OVERRUN_CATCH_UP;
+            } else {
+                std::cout << "Bad overrun policy." << std::endl;
+                show_usage = true;
+                arguments.parse_result = PARSE_RETURN_FAILURE;
+                break;
+            }
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--spin-us") == 0) {
+            arguments.spin_us = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
         } else if (strcmp(argv[arg_processing], "-v") == 0
                 || strcmp(argv[arg_processing], "--verbosity") == 0) {
             arguments.verbosity =
                     (NDDS_Config_LogVerbosity) atoi(argv[arg_processing + 1]);
             arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "-o") == 0
+                || strcmp(argv[arg_processing], "--output") == 0) {
+            if (strcmp(argv[arg_processing + 1], "sync") == 0) {
+                arguments.output_mode = OUTPUT_SYNC;
+            } else if (strcmp(argv[arg_processing + 1], "async") == 0) {
+                arguments.output_mode = OUTPUT_ASYNC;
+            } else if (strcmp(argv[arg_processing + 1], "none") == 0) {
+                arguments.output_mode = OUTPUT_NONE;
+            } else {
+                std::cout << "Bad output mode." << std::endl;
+                show_usage = true;
+                arguments.parse_result = PARSE_RETURN_FAILURE;
+                break;
+            }
+            arg_processing += 2;
         } else if (strcmp(argv[arg_processing], "-h") == 0
                 || strcmp(argv[arg_processing], "--help") == 0) {
             std::cout << "Example application." << std::endl;
@@ -96,6 +250,23 @@ inline void parse_arguments(
                     "    -s, --sample_count <int>   Number of samples to receive before\n"\
                     "                               cleanly shutting down. \n"
                     "                               Default: infinite\n"
+                    "    -r, --rate         <Hz>    Publisher only: samples per second.\n"\
+                    "                               Default: 0.25\n"
+                    "    --overrun    <catch-up|skip>\n"\
+                    "                               Publisher only: what to do with\n"
+                    "                               periods missed when the publisher\n"
+                    "                               falls behind.\n"
+                    "                               Default: catch-up\n"
+                    "    --spin-us          <int>   Publisher only: busy-wait for the\n"\
+                    "                               last microseconds of each period\n"
+                    "                               instead of sleeping.\n"
+                    "                               Default: 0\n"
+                    "    -o, --output <sync|async|none>\n"\
+                    "                               How to print each sample: right\n"
+                    "                               away, from a background thread\n"
+                    "                               (lines may be dropped if it falls\n"
+                    "                               behind), or not at all.\n"
+                    "                               Default: sync\n"
                     "    -v, --verbosity    <int>   How much debugging output to show.\n"\
                     "                               Range: 0-5 \n"
                     "                               Default: 0"
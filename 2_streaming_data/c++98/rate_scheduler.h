@@ -0,0 +1,217 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef RATE_SCHEDULER_H
+#define RATE_SCHEDULER_H
+
+#include <csignal>
+#include <iostream>
+#include <math.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+namespace application {
+
+// Cleared on control-C (see application.h)
+extern volatile sig_atomic_t running;
+
+// The longest a RateScheduler sleeps before checking 'running' again
+const long long RATE_SCHEDULER_MAX_SLEEP_NS = 100000000LL;
+
+// What to do when the loop falls behind its schedule
+enum OverrunPolicy {
+    OVERRUN_CATCH_UP,  // Run the missed periods back-to-back until on schedule
+    OVERRUN_SKIP       // Drop the missed periods and continue from the next one
+};
+
+// Nanoseconds on a monotonic clock. Unlike the system time, this clock never
+// jumps when the system time is changed.
+inline long long monotonic_now_ns()
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (long long) ((double) counter.QuadPart * 1e9
+                        / (double) frequency.QuadPart);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long) now.tv_sec * 1000000000LL + now.tv_nsec;
+#endif
+}
+
+inline void sleep_ns(long long duration_ns)
+{
+#ifdef _WIN32
+    Sleep((DWORD) (duration_ns / 1000000));
+#else
+    struct timespec duration;
+    duration.tv_sec = (time_t) (duration_ns / 1000000000LL);
+    duration.tv_nsec = (long) (duration_ns % 1000000000LL);
+    nanosleep(&duration, NULL);
+#endif
+}
+
+// Paces a loop at a fixed rate using absolute deadlines on a monotonic
+// clock. Because each deadline is computed from the start time rather than
+// from the end of the previous iteration, the time spent in the loop body
+// does not make the rate drift. Control-C interrupts a wait, so a slow rate
+// does not delay shutting down by up to a period.
+//
+// The achieved rate is measured until stop(), so that what the loop does
+// after its last period (such as waiting for the DataReaders to acknowledge
+// the last samples) does not lower it.
+class RateScheduler {
+public:
+    // rate_hz: periods per second. 0 means unpaced (wait() never blocks).
+    // spin_ns: how long before the deadline to stop sleeping and busy-wait.
+    //          Sleeping alone usually wakes up tens of microseconds late.
+    RateScheduler(
+            double rate_hz,
+            OverrunPolicy policy = OVERRUN_CATCH_UP,
+            long long spin_ns = 0)
+            : period_ns_(rate_hz > 0 ? (long long) (1e9 / rate_hz + 0.5) : 0),
+              policy_(policy),
+              spin_ns_(spin_ns),
+              start_ns_(monotonic_now_ns()),
+              next_deadline_ns_(start_ns_),
+              end_ns_(start_ns_),
+              stopped_(false),
+              periods_(0),
+              skipped_(0),
+              jitter_mean_ns_(0),
+              jitter_m2_(0),
+              jitter_max_ns_(0)
+    {
+    }
+
+    // Blocks until the next period starts. The first call returns
+    // immediately. Returns false if control-C interrupted it.
+    bool wait()
+    {
+        if (period_ns_ == 0) {
+            periods_++;
+            return true;
+        }
+
+        // Sleeps RATE_SCHEDULER_MAX_SLEEP_NS at most at a time, then
+        // busy-waits
+        long long now = monotonic_now_ns();
+        while (now < next_deadline_ns_ - spin_ns_) {
+            if (!running) {
+                return false;
+            }
+            long long sleep = next_deadline_ns_ - spin_ns_ - now;
+            sleep_ns(sleep < RATE_SCHEDULER_MAX_SLEEP_NS
+                             ? sleep
+                             : RATE_SCHEDULER_MAX_SLEEP_NS);
+            now = monotonic_now_ns();
+        }
+        while (now < next_deadline_ns_) {
+            // Spin for the last few microseconds
+            now = monotonic_now_ns();
+        }
+
+        record_jitter((double) (now - next_deadline_ns_));
+        periods_++;
+        next_deadline_ns_ += period_ns_;
+
+        // More than a full period late: either keep the missed periods and
+        // run them back-to-back, or forget about them
+        if (policy_ == OVERRUN_SKIP && now >= next_deadline_ns_) {
+            long long missed = (now - next_deadline_ns_) / period_ns_ + 1;
+            skipped_ += missed;
+            next_deadline_ns_ += missed * period_ns_;
+        }
+        return true;
+    }
+
+    // Ends the time the achieved rate is measured over. Call it when the
+    // loop ends; otherwise print_report() measures until it is called.
+    void stop()
+    {
+        if (!stopped_) {
+            end_ns_ = monotonic_now_ns();
+            stopped_ = true;
+        }
+    }
+
+    // Number of periods completed so far
+    long long periods() const
+    {
+        return periods_;
+    }
+
+    // Number of periods dropped by the OVERRUN_SKIP policy
+    long long skipped() const
+    {
+        return skipped_;
+    }
+
+    // Prints the achieved rate and how late each period started
+    void print_report(std::ostream& out) const
+    {
+        double elapsed =
+                ((stopped_ ? end_ns_ : monotonic_now_ns()) - start_ns_) / 1e9;
+        out << "Periods: " << periods_ << ", skipped: " << skipped_
+            << ", achieved rate: " << (elapsed > 0 ? periods_ / elapsed : 0)
+            << " Hz";
+        if (period_ns_ > 0) {
+            out << " (target " << 1e9 / period_ns_ << " Hz)"
+                << "\nSchedule jitter: mean " << jitter_mean_ns_ / 1000.0
+                << " us, stddev " << jitter_stddev_ns() / 1000.0
+                << " us, max " << jitter_max_ns_ / 1000.0 << " us";
+        }
+        out << std::endl;
+    }
+
+private:
+    void record_jitter(double lateness_ns)
+    {
+        // Welford's online mean and variance
+        long long n = periods_ + 1;
+        double delta = lateness_ns - jitter_mean_ns_;
+        jitter_mean_ns_ += delta / n;
+        jitter_m2_ += delta * (lateness_ns - jitter_mean_ns_);
+        if (lateness_ns > jitter_max_ns_) {
+            jitter_max_ns_ = lateness_ns;
+        }
+    }
+
+    double jitter_stddev_ns() const
+    {
+        return periods_ > 1 ? sqrt(jitter_m2_ / (periods_ - 1)) : 0;
+    }
+
+    long long period_ns_;
+    OverrunPolicy policy_;
+    long long spin_ns_;
+    long long start_ns_;
+    long long next_deadline_ns_;
+    long long end_ns_;
+    bool stopped_;
+    long long periods_;
+    long long skipped_;
+    double jitter_mean_ns_;
+    double jitter_m2_;
+    double jitter_max_ns_;
+};
+
+}  // namespace application
+
+#endif  // RATE_SCHEDULER_H
@@ -29,7 +29,10 @@ static int shutdown(
 int run_example(
         unsigned int domain_id,
         unsigned int sample_count,
-        const char *sensor_id)
+        const char *sensor_id,
+        double rate,
+        OverrunPolicy overrun_policy,
+        unsigned int spin_us)
 {
     // Connext DDS setup
     // -----------------
@@ -104,27 +107,44 @@ int run_example(
                 EXIT_FAILURE);
     }
 
+    // Register the sensor (instance) once. Writing with the returned handle
+    // saves hashing the sensor_id key on every write
+    snprintf(sample->sensor_id, 255, "%s", sensor_id);
+    DDS_InstanceHandle_t instance_handle =
+            Temperature_writer->register_instance(*sample);
+
+    // Printing every write would limit the rate more than DDS does
+    bool print_writes = rate <= 10;
+
+    // Exercise: Change the rate to write one temperature every 10 ms
+    RateScheduler scheduler(rate, overrun_policy, spin_us * 1000LL);
+
     // Main loop, write data
     // ---------------------
     for (unsigned int count = 0;
          running && ((sample_count == 0) || (count < sample_count));
          ++count) {
+        // Wait for the start of this sample's period. The deadlines are
+        // absolute, so the time spent writing does not slow the rate down
+        if (!scheduler.wait()) {
+            break;  // Control-C
+        }
+
         // Modify the data to be written here
-        snprintf(sample->sensor_id, 255, "%s", sensor_id);
         sample->degrees = rand() % 3 + 30;  // Random number between 30 and 32
 
-
-        std::cout << "Writing ChocolateTemperature, count " << count
-                  << std::endl;
-        retcode = Temperature_writer->write(*sample, DDS_HANDLE_NIL);
+        if (print_writes) {
+            console.print("Writing ChocolateTemperature, count %u", count);
+        }
+        retcode = Temperature_writer->write(*sample, instance_handle);
         if (retcode != DDS_RETCODE_OK) {
             std::cerr << "write error " << retcode << std::endl;
         }
-
-        // Exercise: Change this to sleep 10 ms in between writing temperatures
-        DDS_Duration_t send_period = { 4, 0 };
-        NDDSUtility::sleep(send_period);
     }
+    scheduler.stop();
+    wait_for_acknowledgments_on_exit(writer);
+    console.stop();  // Print the queued lines before the report
+    scheduler.print_report(std::cout);
 
     // Cleanup
     // -------
@@ -147,6 +167,7 @@ static int shutdown(
 {
     DDS_ReturnCode_t retcode;
 
+    console.stop();  // Print the queued lines first
     std::cout << shutdown_message << std::endl;
 
     if (participant != NULL) {
@@ -190,11 +211,17 @@ int main(int argc, char *argv[])
 
     // Enables different levels of debugging output
     set_verbosity(arguments.verbosity);
+    console.start(arguments.output_mode);
 
     int status = run_example(
             arguments.domain_id,
             arguments.sample_count,
-            arguments.sensor_id);
+            arguments.sensor_id,
+            arguments.rate,
+            arguments.overrun_policy,
+            arguments.spin_us);
+
+    teardown_signal_handlers();
 
     // Releases the memory used by the participant factory.  Optional at
     // application shutdown
@@ -0,0 +1,241 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef APPLICATION_HPP
+#define APPLICATION_HPP
+
+#include <atomic>
+#include <iostream>
+#include <csignal>
+#include <thread>
+#include <string>
+#ifndef _WIN32
+    #include <cerrno>
+    #include <unistd.h>
+#endif
+#include <dds/core/ddscore.hpp>
+
+
+namespace application {
+
+// Catch control-C and tell application to shut down. The signal handler
+// sets it, so it must be lock-free.
+static_assert(ATOMIC_BOOL_LOCK_FREE == 2, "running must be lock-free");
+std::atomic<bool> running(true);
+
+// Triggered on control-C. A loop that attaches it to its WaitSet wakes up
+// at once, instead of when its wait() or dispatch() times out.
+inline dds::core::cond::GuardCondition& shutdown_condition()
+{
+    static dds::core::cond::GuardCondition condition;
+    return condition;
+}
+
+inline void request_shutdown()
+{
+    std::cout << "preparing to shut down..." << std::endl;
+    shutdown_condition().trigger_value(true);
+}
+
+#ifndef _WIN32
+// A signal handler may only call async-signal-safe functions, which
+// trigger_value() is not. It writes to this pipe instead, and a thread
+// blocked reading it calls request_shutdown().
+int shutdown_pipe[2] = { -1, -1 };
+std::thread shutdown_thread;
+#endif
+
+inline void stop_handler(int)
+{
+    running = false;
+#ifdef _WIN32
+    // Windows runs the handler in a thread of its own
+    request_shutdown();
+#else
+    char signal_byte = 0;
+    ssize_t written = write(shutdown_pipe[1], &signal_byte, 1);
+    (void) written;  // Without the pipe, loops stop at their next timeout
+#endif
+}
+
+inline void setup_signal_handlers()
+{
+    shutdown_condition();  // Created here, not in the signal path
+#ifndef _WIN32
+    if (pipe(shutdown_pipe) == 0) {
+        shutdown_thread = std::thread([]() {
+            char signal_byte;
+            ssize_t result;
+            while ((result = read(shutdown_pipe[0], &signal_byte, 1)) != 0) {
+                if (result == 1) {
+                    request_shutdown();
+                } else if (errno != EINTR) {
+                    break;
+                }
+            }
+        });
+    }
+#endif
+    signal(SIGINT, stop_handler);
+    signal(SIGTERM, stop_handler);
+}
+
+// After this, control-C only stops the loops that check 'running'
+inline void stop_running_handler(int)
+{
+    running = false;
+}
+
+// Stops the thread that triggers shutdown_condition(). Call it before
+// finalizing the participant factory and returning from main(), so that
+// the thread does not use the condition after that.
+inline void teardown_signal_handlers()
+{
+    signal(SIGINT, stop_running_handler);
+    signal(SIGTERM, stop_running_handler);
+#ifndef _WIN32
+    if (shutdown_thread.joinable()) {
+        // A stop_handler() already running writes to -1 and fails
+        int write_end = shutdown_pipe[1];
+        shutdown_pipe[1] = -1;
+        close(write_end);  // The thread reads the end of the pipe and exits
+        shutdown_thread.join();
+        close(shutdown_pipe[0]);
+        shutdown_pipe[0] = -1;
+    }
+#endif
+}
+
+// How long a publisher waits at exit for the matched DataReaders to
+// acknowledge its last samples, which are lost if its DataWriter is deleted
+// first
+const dds::core::Duration SHUTDOWN_ACK_TIMEOUT(1);
+
+// Returns false if not all the samples were acknowledged in time
+template <typename Writer>
+bool wait_for_acknowledgments_on_exit(Writer& writer)
+{
+    try {
+        writer.wait_for_acknowledgments(SHUTDOWN_ACK_TIMEOUT);
+        return true;
+    } catch (const dds::core::TimeoutError&) {
+        std::cout << "Not all samples were acknowledged before shutting down"
+                  << std::endl;
+        return false;
+    }
+}
+
+enum class ParseReturn {
+    PARSE_RETURN_OK,
+    PARSE_RETURN_FAILURE,
+    PARSE_RETURN_EXIT
+};
+
+struct ApplicationArguments {
+    ParseReturn parse_result;
+    unsigned int domain_id;
+    unsigned int sample_count;
+    unsigned int lots;
+    double rate;
+    std::string qos_profile;
+    rti::config::Verbosity verbosity;
+};
+
+// Parses application arguments for example.
+inline ApplicationArguments parse_arguments(int argc, char *argv[])
+{
+    int arg_processing = 1;
+    bool show_usage = false;
+    ParseReturn parse_result = ParseReturn::PARSE_RETURN_OK;
+    unsigned int domain_id = 0;
+    unsigned int sample_count = 0;  // Infinite
+    unsigned int lots = 5000;
+    double rate = 100;
+    std::string qos_profile =
+            "ChocolateFactoryLibrary::ChocolateLotStateProfile";
+    rti::config::Verbosity verbosity(rti::config::Verbosity::EXCEPTION);
+
+    while (arg_processing < argc) {
+        if (strcmp(argv[arg_processing], "-d") == 0
+                || strcmp(argv[arg_processing], "--domain") == 0) {
+            domain_id = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "-s") == 0
+                || strcmp(argv[arg_processing], "--sample-count") == 0) {
+            sample_count = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "-v") == 0
+                || strcmp(argv[arg_processing], "--verbosity") == 0) {
+            verbosity =
+                    static_cast<rti::config::Verbosity::inner_enum>(
+                            atoi(argv[arg_processing + 1]));
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--lots") == 0) {
+            lots = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "-r") == 0
+                || strcmp(argv[arg_processing], "--rate") == 0) {
+            rate = atof(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "--qos-profile") == 0) {
+            qos_profile = argv[arg_processing + 1];
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "-h") == 0
+                || strcmp(argv[arg_processing], "--help") == 0) {
+            std::cout << "Example application." << std::endl;
+            show_usage = true;
+            parse_result = ParseReturn::PARSE_RETURN_EXIT;
+            break;
+        } else {
+            std::cout << "Bad parameter." << std::endl;
+            show_usage = true;
+            parse_result = ParseReturn::PARSE_RETURN_FAILURE;
+            break;
+        }
+    }
+    if (show_usage) {
+        std::cout << "Usage:\n"\
+                    "    -d, --domain       <int>   Domain ID this application will\n" \
+                    "                               subscribe in.  \n"
+                    "                               Default: 0\n"\
+                    "    -s, --sample_count <int>   Number of samples to receive before\n"\
+                    "                               cleanly shutting down. \n"
+                    "                               Benchmark: number of late joiners.\n"
+                    "                               Default: infinite (benchmark: 5)\n"
+                    "    --lots             <int>   Number of lots in the factory at any\n"\
+                    "                               time. Subscriber: lots expected.\n"
+                    "                               Default: 5000\n"
+                    "    -r, --rate         <Hz>    Publisher only: lot state updates\n"\
+                    "                               per second.\n"
+                    "                               Default: 100\n"
+                    "    --qos-profile      <name>  QoS profile to use, as\n"\
+                    "                               <library>::<profile>\n"
+                    "                               Default: ChocolateFactoryLibrary::\n"
+                    "                               ChocolateLotStateProfile\n"
+                    "    -v, --verbosity    <int>   How much debugging output to show.\n"\
+                    "                               Range: 0-5 \n"
+                    "                               Default: 0"
+                << std::endl;
+    }
+
+    return { parse_result,
+             domain_id,
+             sample_count,
+             lots,
+             rate,
+             qos_profile,
+             verbosity };
+}
+
+}  // namespace application
+
+#endif  // APPLICATION_HPP
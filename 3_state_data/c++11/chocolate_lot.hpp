@@ -0,0 +1,62 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef CHOCOLATE_LOT_HPP
+#define CHOCOLATE_LOT_HPP
+
+#include <cstdint>
+
+#include "chocolate_lot_state.hpp"
+
+namespace application {
+
+// A new lot, waiting for the first station
+inline ChocolateLotState new_lot(uint32_t lot_id)
+{
+    ChocolateLotState lot;
+    lot.lot_id(lot_id);
+    lot.station(StationKind::INVALID_CONTROLLER);
+    lot.next_station(StationKind::COCOA_BUTTER_CONTROLLER);
+    lot.lot_status(LotStatusKind::WAITING);
+    return lot;
+}
+
+// Moves a lot to its next state: it waits for a station, is processed there,
+// then waits for the next station. A lot processed at the tempering station
+// is completed.
+inline void advance_lot(ChocolateLotState& lot)
+{
+    switch (lot.lot_status()) {
+    case LotStatusKind::WAITING:
+        lot.station(lot.next_station());
+        lot.lot_status(LotStatusKind::PROCESSING);
+        if (lot.station() == StationKind::TEMPERING_CONTROLLER) {
+            lot.next_station(StationKind::INVALID_CONTROLLER);
+        } else {
+            lot.next_station(static_cast<StationKind>(
+                    static_cast<int>(lot.station()) + 1));
+        }
+        break;
+    case LotStatusKind::PROCESSING:
+        lot.lot_status(
+                lot.station() == StationKind::TEMPERING_CONTROLLER
+                        ? LotStatusKind::COMPLETED
+                        : LotStatusKind::WAITING);
+        break;
+    case LotStatusKind::COMPLETED:
+        break;
+    }
+}
+
+}  // namespace application
+
+#endif  // CHOCOLATE_LOT_HPP
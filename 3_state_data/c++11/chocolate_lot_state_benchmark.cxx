@@ -0,0 +1,235 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+// Measures how long a late-joining subscriber takes to rebuild the state of
+// the chocolate lots.
+//
+// A DataWriter publishes --lots lots and moves each of them through
+// UPDATES_PER_LOT states. Then -s subscribers join late, one after the other,
+// each with a new DomainParticipant, and for each of them the benchmark
+// measures:
+//   - discovery: from the creation of the DataReader until it matches the
+//     DataWriter
+//   - rebuild: from the match until the LotStateCache holds the latest state
+//     of every lot
+// It also prints the samples each subscriber received: with KEEP_LAST 1 there
+// is one per lot, however many updates were written.
+//
+//   chocolate_lot_state_benchmark [--lots <n>] [-s <late joiners>]
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dds/domain/ddsdomain.hpp>
+#include <dds/pub/ddspub.hpp>
+#include <dds/sub/ddssub.hpp>
+#include <rti/config/Logger.hpp>  // for logging
+// Or simply include <dds/dds.hpp>
+
+#include "chocolate_lot_state.hpp"
+#include "application.hpp"  // Argument parsing
+#include "chocolate_lot.hpp"
+#include "lot_state_cache.hpp"
+
+using namespace application;
+
+// Each lot waits for and is processed at the first two stations
+const unsigned int UPDATES_PER_LOT = 4;
+const unsigned int DEFAULT_LATE_JOINERS = 5;
+const std::chrono::milliseconds DISCOVERY_TIMEOUT(10000);
+const std::chrono::milliseconds REBUILD_TIMEOUT(10000);
+// Not the ChocolateLotState topic, so that a running publisher and
+// subscriber neither receive nor disturb the benchmark's lots
+const std::string TOPIC_NAME = "ChocolateLotStateBenchmark";
+
+struct LateJoinerTimes {
+    double discovery_ms;
+    double rebuild_ms;
+    size_t samples;
+};
+
+// Creates a new DomainParticipant and DataReader, and waits until its cache
+// holds 'lot_count' lots
+LateJoinerTimes join_late(
+        unsigned int domain_id,
+        unsigned int lot_count,
+        const std::string& qos_profile)
+{
+    dds::core::QosProvider qos_provider = dds::core::QosProvider::Default();
+    dds::domain::DomainParticipant participant(
+            domain_id,
+            qos_provider.participant_qos(qos_profile));
+    dds::topic::Topic<ChocolateLotState> topic(
+            participant,
+            TOPIC_NAME);
+    dds::sub::Subscriber subscriber(participant);
+
+    auto start_time = std::chrono::steady_clock::now();
+    dds::sub::DataReader<ChocolateLotState> reader(
+            subscriber,
+            topic,
+            qos_provider.datareader_qos(qos_profile));
+    while (reader.subscription_matched_status().current_count() == 0) {
+        if (!running
+                || std::chrono::steady_clock::now() - start_time
+                        > DISCOVERY_TIMEOUT) {
+            throw std::runtime_error("The DataWriter was not discovered");
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    auto matched_time = std::chrono::steady_clock::now();
+
+    // Take the samples as they arrive instead of waiting for all of them
+    // first, as a subscriber with a WaitSet would
+    LotStateCache cache(lot_count);
+    size_t samples = 0;
+    while (cache.size() < lot_count) {
+        dds::sub::LoanedSamples<ChocolateLotState> taken = reader.take();
+        samples += taken.length();
+        cache.apply(reader, taken);
+        if (taken.length() == 0) {
+            if (!running
+                    || std::chrono::steady_clock::now() - matched_time
+                            > REBUILD_TIMEOUT) {
+                throw std::runtime_error("Not all the lots were received");
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+    auto rebuilt_time = std::chrono::steady_clock::now();
+
+    std::chrono::duration<double, std::milli> discovery =
+            matched_time - start_time;
+    std::chrono::duration<double, std::milli> rebuild =
+            rebuilt_time - matched_time;
+    return { discovery.count(), rebuild.count(), samples };
+}
+
+void print_times(
+        const std::string& name,
+        const std::vector<LateJoinerTimes>& times,
+        double LateJoinerTimes::*field)
+{
+    double min = times[0].*field;
+    double max = min;
+    double sum = 0;
+    for (const auto& time : times) {
+        min = std::min(min, time.*field);
+        max = std::max(max, time.*field);
+        sum += time.*field;
+    }
+    std::cout << name << " (ms): min " << min << ", mean "
+              << sum / times.size() << ", max " << max << std::endl;
+}
+
+void run_example(
+        unsigned int domain_id,
+        unsigned int late_joiners,
+        unsigned int lot_count,
+        const std::string& qos_profile)
+{
+    if (late_joiners == 0) {
+        late_joiners = DEFAULT_LATE_JOINERS;
+    }
+    lot_count = std::max(1u, lot_count);
+
+    dds::core::QosProvider qos_provider = dds::core::QosProvider::Default();
+    dds::domain::DomainParticipant participant(
+            domain_id,
+            qos_provider.participant_qos(qos_profile));
+    dds::topic::Topic<ChocolateLotState> topic(
+            participant,
+            TOPIC_NAME);
+    dds::pub::Publisher publisher(participant);
+    dds::pub::DataWriter<ChocolateLotState> writer(
+            publisher,
+            topic,
+            qos_provider.datawriter_qos(qos_profile));
+
+    uint64_t written = 0;
+    for (unsigned int i = 0; i < lot_count; i++) {
+        ChocolateLotState state = new_lot(i);
+        dds::core::InstanceHandle handle = writer.register_instance(state);
+        writer.write(state, handle);
+        for (unsigned int update = 0; update < UPDATES_PER_LOT; update++) {
+            advance_lot(state);
+            writer.write(state, handle);
+        }
+        written += UPDATES_PER_LOT + 1;
+    }
+    std::cout << "Wrote " << written << " updates of " << lot_count
+              << " lots" << std::endl;
+
+    std::vector<LateJoinerTimes> times;
+    for (unsigned int i = 0; running && i < late_joiners; i++) {
+        times.push_back(join_late(domain_id, lot_count, qos_profile));
+        const LateJoinerTimes& time = times.back();
+        std::cout << "Late joiner " << i + 1 << ": discovery "
+                  << time.discovery_ms << " ms, rebuilt " << lot_count
+                  << " lots from " << time.samples << " samples in "
+                  << time.rebuild_ms << " ms" << std::endl;
+    }
+    if (times.empty()) {
+        return;
+    }
+
+    print_times("Discovery", times, &LateJoinerTimes::discovery_ms);
+    print_times("Rebuild", times, &LateJoinerTimes::rebuild_ms);
+}
+
+// Sets Connext verbosity to help debugging
+void set_verbosity(rti::config::Verbosity verbosity)
+{
+    rti::config::Logger::instance().verbosity(verbosity);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::PARSE_RETURN_EXIT) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::PARSE_RETURN_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Enables different levels of debugging output
+    set_verbosity(arguments.verbosity);
+
+    try {
+        run_example(
+                arguments.domain_id,
+                arguments.sample_count,
+                arguments.lots,
+                arguments.qos_profile);
+    } catch (const std::exception& ex) {
+        // This will catch DDS exceptions
+        std::cerr << "Exception in benchmark_main(): " << ex.what()
+                  << std::endl;
+        teardown_signal_handlers();
+        return EXIT_FAILURE;
+    }
+
+    teardown_signal_handlers();
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,155 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+// Keeps --lots chocolate lots moving through the factory, and publishes the
+// state of each lot as it changes. Every lot is a separate instance of the
+// ChocolateLotState topic, and the DataWriter keeps the latest state of each
+// one (TRANSIENT_LOCAL, KEEP_LAST 1), so a subscriber started at any time
+// receives the current state of all the lots without replaying their history.
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include <dds/pub/ddspub.hpp>
+#include <rti/util/util.hpp>  // for sleep()
+#include <rti/config/Logger.hpp>  // for logging
+// Or simply include <dds/dds.hpp>
+
+#include "chocolate_lot_state.hpp"
+#include "application.hpp"  // Argument parsing
+#include "chocolate_lot.hpp"
+
+using namespace application;
+
+void run_example(
+        unsigned int domain_id,
+        unsigned int sample_count,
+        unsigned int lot_count,
+        double rate,
+        const std::string& qos_profile)
+{
+    dds::core::QosProvider qos_provider = dds::core::QosProvider::Default();
+
+    // A DomainParticipant allows an application to begin communicating in
+    // a DDS domain. Typically there is one DomainParticipant per application.
+    // DomainParticipant QoS is configured in USER_QOS_PROFILES.xml
+    dds::domain::DomainParticipant participant(
+            domain_id,
+            qos_provider.participant_qos(qos_profile));
+
+    // A Topic has a name and a datatype. Create a Topic named
+    // "ChocolateLotState" with type ChocolateLotState
+    dds::topic::Topic<ChocolateLotState> topic(
+            participant,
+            "ChocolateLotState");
+
+    // A Publisher allows an application to create one or more DataWriters
+    // Publisher QoS is configured in USER_QOS_PROFILES.xml
+    dds::pub::Publisher publisher(participant);
+
+    // This DataWriter writes data on Topic "ChocolateLotState"
+    // DataWriter QoS is configured in USER_QOS_PROFILES.xml
+    dds::pub::DataWriter<ChocolateLotState> writer(
+            publisher,
+            topic,
+            qos_provider.datawriter_qos(qos_profile));
+
+    // Every lot is registered once, and written with its instance handle
+    // so that each update does not look the instance up by key
+    lot_count = std::max(1u, lot_count);
+    std::vector<ChocolateLotState> lots;
+    std::vector<dds::core::InstanceHandle> handles;
+    lots.reserve(lot_count);
+    handles.reserve(lot_count);
+    uint32_t next_lot_id = 0;
+    for (unsigned int i = 0; i < lot_count; i++) {
+        lots.push_back(new_lot(next_lot_id++));
+        handles.push_back(writer.register_instance(lots.back()));
+        writer.write(lots.back(), handles.back());
+    }
+    std::cout << "Published the state of " << lot_count << " lots"
+              << std::endl;
+
+    // Updates the lots one after the other, at 'rate' updates per second
+    dds::core::Duration period =
+            dds::core::Duration::from_secs(rate > 0 ? 1.0 / rate : 0);
+    size_t next = 0;
+    for (unsigned int count = 0;
+         running && (count < sample_count || sample_count == 0);
+         count++) {
+        ChocolateLotState& lot = lots[next];
+        advance_lot(lot);
+        writer.write(lot, handles[next]);
+        if (lot.lot_status() == LotStatusKind::COMPLETED) {
+            // The lot leaves the factory: late joiners will not receive it.
+            // A new lot takes its place.
+            writer.dispose_instance(handles[next]);
+            writer.unregister_instance(handles[next]);
+            lot = new_lot(next_lot_id++);
+            handles[next] = writer.register_instance(lot);
+            writer.write(lot, handles[next]);
+        }
+        next = (next + 1) % lots.size();
+
+        if (count % 1000 == 0) {
+            std::cout << count << " lot state updates, " << next_lot_id
+                      << " lots started" << std::endl;
+        }
+        rti::util::sleep(period);
+    }
+    wait_for_acknowledgments_on_exit(writer);
+}
+
+// Sets Connext verbosity to help debugging
+void set_verbosity(rti::config::Verbosity verbosity)
+{
+    rti::config::Logger::instance().verbosity(verbosity);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::PARSE_RETURN_EXIT) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::PARSE_RETURN_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Enables different levels of debugging output
+    set_verbosity(arguments.verbosity);
+
+    try {
+        run_example(
+                arguments.domain_id,
+                arguments.sample_count,
+                arguments.lots,
+                arguments.rate,
+                arguments.qos_profile);
+    } catch (const std::exception& ex) {
+        // This will catch DDS exceptions
+        std::cerr << "Exception in publisher_main(): " << ex.what()
+                  << std::endl;
+        teardown_signal_handlers();
+        return EXIT_FAILURE;
+    }
+
+    teardown_signal_handlers();
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,191 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+// Keeps the current state of every chocolate lot in a LotStateCache. When it
+// starts after chocolate_lot_state_publisher, it first receives the latest
+// state of each lot that is still in the factory, and prints how long
+// rebuilding the cache took. After that, every update only changes the state
+// of its lot.
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include <dds/sub/ddssub.hpp>
+#include <dds/core/ddscore.hpp>
+#include <rti/config/Logger.hpp>  // for logging
+// Or simply include <dds/dds.hpp>
+
+#include "chocolate_lot_state.hpp"
+#include "application.hpp"  // Argument parsing
+#include "lot_state_cache.hpp"
+
+using namespace application;
+
+// Includes the discovery of the publisher
+const std::chrono::milliseconds DISCOVERY_TIMEOUT(10000);
+const dds::core::Duration HISTORICAL_DATA_TIMEOUT(10);
+
+unsigned int process_data(
+        dds::sub::DataReader<ChocolateLotState>& reader,
+        LotStateCache& cache)
+{
+    // Take all samples.  Samples are loaned to application, loan is
+    // returned when LoanedSamples destructor called.
+    dds::sub::LoanedSamples<ChocolateLotState> samples = reader.take();
+    return static_cast<unsigned int>(cache.apply(reader, samples));
+}  // The LoanedSamples destructor returns the loan
+
+// Returns false if no DataWriter matched 'reader' within 'timeout'
+bool wait_for_writer(
+        dds::sub::DataReader<ChocolateLotState>& reader,
+        std::chrono::milliseconds timeout)
+{
+    auto end_time = std::chrono::steady_clock::now() + timeout;
+    while (reader.subscription_matched_status().current_count() == 0) {
+        if (!running || std::chrono::steady_clock::now() >= end_time) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+void run_example(
+        unsigned int domain_id,
+        unsigned int sample_count,
+        unsigned int expected_lots,
+        const std::string& qos_profile)
+{
+    dds::core::QosProvider qos_provider = dds::core::QosProvider::Default();
+
+    // A DomainParticipant allows an application to begin communicating in
+    // a DDS domain. Typically there is one DomainParticipant per application.
+    // DomainParticipant QoS is configured in USER_QOS_PROFILES.xml
+    dds::domain::DomainParticipant participant(
+            domain_id,
+            qos_provider.participant_qos(qos_profile));
+
+    // A Topic has a name and a datatype. Create a Topic named
+    // "ChocolateLotState" with type ChocolateLotState
+    dds::topic::Topic<ChocolateLotState> topic(
+            participant,
+            "ChocolateLotState");
+
+    // A Subscriber allows an application to create one or more DataReaders
+    // Subscriber QoS is configured in USER_QOS_PROFILES.xml
+    dds::sub::Subscriber subscriber(participant);
+
+    // This DataReader reads data of type ChocolateLotState on Topic
+    // "ChocolateLotState". DataReader QoS is configured in
+    // USER_QOS_PROFILES.xml
+    auto start_time = std::chrono::steady_clock::now();
+    dds::sub::DataReader<ChocolateLotState> reader(
+            subscriber,
+            topic,
+            qos_provider.datareader_qos(qos_profile));
+
+    // Rebuild the state of the lots from the publisher's DataWriter cache:
+    // it sends the latest state of each lot once, not the updates that led
+    // to it
+    LotStateCache cache(expected_lots);
+    if (wait_for_writer(reader, DISCOVERY_TIMEOUT)) {
+        auto matched_time = std::chrono::steady_clock::now();
+        try {
+            reader.wait_for_historical_data(HISTORICAL_DATA_TIMEOUT);
+        } catch (const dds::core::TimeoutError&) {
+            std::cout << "Not all historical data received" << std::endl;
+        }
+        unsigned int samples_read = process_data(reader, cache);
+        auto rebuilt_time = std::chrono::steady_clock::now();
+        std::chrono::duration<double, std::milli> discovery =
+                matched_time - start_time;
+        std::chrono::duration<double, std::milli> rebuild =
+                rebuilt_time - matched_time;
+        std::cout << "Rebuilt the state of " << cache.size() << " lots from "
+                  << samples_read << " samples in " << rebuild.count()
+                  << " ms (publisher discovered in " << discovery.count()
+                  << " ms)" << std::endl;
+        cache.print_summary(std::cout);
+    } else {
+        std::cout << "No ChocolateLotState publisher yet" << std::endl;
+    }
+
+    // Obtain the DataReader's Status Condition
+    dds::core::cond::StatusCondition status_condition(reader);
+
+    // Enable the 'data available' status.
+    status_condition.enabled_statuses(
+            dds::core::status::StatusMask::data_available());
+
+    // Associate a handler with the status condition. This will run when the
+    // condition is triggered, in the context of the dispatch call (see below)
+    unsigned int samples_read = 0;
+    status_condition.extensions().handler([&reader, &cache, &samples_read]() {
+        samples_read += process_data(reader, cache);
+    });
+
+    // Create a WaitSet and attach the StatusCondition
+    dds::core::cond::WaitSet waitset;
+    waitset += status_condition;
+    waitset += shutdown_condition();  // Wakes it up on control-C
+
+    while (running && (samples_read < sample_count || sample_count == 0)) {
+        // Dispatch will call the handlers associated to the WaitSet conditions
+        // when they activate
+        waitset.dispatch(dds::core::Duration(4));  // Wait up to 4s each time
+        cache.print_summary(std::cout);
+    }
+}
+
+// Sets Connext verbosity to help debugging
+void set_verbosity(rti::config::Verbosity verbosity)
+{
+    rti::config::Logger::instance().verbosity(verbosity);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::PARSE_RETURN_EXIT) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::PARSE_RETURN_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Enables different levels of debugging output
+    set_verbosity(arguments.verbosity);
+
+    try {
+        run_example(
+                arguments.domain_id,
+                arguments.sample_count,
+                arguments.lots,
+                arguments.qos_profile);
+    } catch (const std::exception& ex) {
+        // All DDS exceptions inherit from std::exception
+        std::cerr << "Exception in subscriber_main(): " << ex.what()
+                  << std::endl;
+        teardown_signal_handlers();
+        return EXIT_FAILURE;
+    }
+
+    teardown_signal_handlers();
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,169 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef LOT_STATE_CACHE_HPP
+#define LOT_STATE_CACHE_HPP
+
+#include <cstdint>
+#include <iostream>
+#include <unordered_map>
+
+#include <dds/sub/ddssub.hpp>
+
+#include "chocolate_lot_state.hpp"
+
+namespace application {
+
+// Values of the enums in chocolate_lot_state.idl
+const size_t STATION_COUNT =
+        static_cast<size_t>(StationKind::TEMPERING_CONTROLLER) + 1;
+const size_t LOT_STATUS_COUNT =
+        static_cast<size_t>(LotStatusKind::COMPLETED) + 1;
+
+// The current state of every lot, built from the samples of the
+// ChocolateLotState DataReader. Each sample replaces the state of its lot,
+// and a disposed lot is removed, so the cost of an update does not depend on
+// the number of lots. The number of lots at each station and in each status
+// is kept up to date with every change, instead of being counted when
+// printed.
+class LotStateCache {
+public:
+    struct Lot {
+        StationKind station;
+        StationKind next_station;
+        LotStatusKind lot_status;
+    };
+
+    // expected_lots: the hash table is sized for this many lots up front,
+    // so a late joiner receiving them all at once does not rehash
+    explicit LotStateCache(size_t expected_lots = 0)
+            : station_counts_(), status_counts_()
+    {
+        lots_.reserve(expected_lots);
+    }
+
+    // Applies the samples taken or read from 'reader', in order. Returns the
+    // number of samples that changed the cache.
+    size_t apply(
+            dds::sub::DataReader<ChocolateLotState>& reader,
+            const dds::sub::LoanedSamples<ChocolateLotState>& samples)
+    {
+        size_t changes = 0;
+        for (const auto& sample : samples) {
+            if (sample.info().valid()) {
+                update(sample.data());
+                changes++;
+            } else if (
+                    sample.info().state().instance_state()
+                    == dds::sub::status::InstanceState::not_alive_disposed()) {
+                // The lot is completed. A lot whose DataWriters are gone
+                // (not_alive_no_writers) keeps its last known state.
+                // Invalid samples only carry the instance handle of the lot.
+                ChocolateLotState key_holder;
+                reader.key_value(key_holder, sample.info().instance_handle());
+                if (remove(key_holder.lot_id())) {
+                    changes++;
+                }
+            }
+        }
+        return changes;
+    }
+
+    void update(const ChocolateLotState& state)
+    {
+        auto inserted = lots_.insert(std::make_pair(state.lot_id(), Lot()));
+        Lot& lot = inserted.first->second;
+        if (!inserted.second) {
+            uncount(lot);
+        }
+        lot.station = state.station();
+        lot.next_station = state.next_station();
+        lot.lot_status = state.lot_status();
+        count(lot);
+    }
+
+    // Returns false if the lot was not in the cache
+    bool remove(uint32_t lot_id)
+    {
+        auto found = lots_.find(lot_id);
+        if (found == lots_.end()) {
+            return false;
+        }
+        uncount(found->second);
+        lots_.erase(found);
+        return true;
+    }
+
+    // Returns nullptr if the lot is not in the cache
+    const Lot *find(uint32_t lot_id) const
+    {
+        auto found = lots_.find(lot_id);
+        return found != lots_.end() ? &found->second : nullptr;
+    }
+
+    size_t size() const
+    {
+        return lots_.size();
+    }
+
+    size_t count_at(StationKind station) const
+    {
+        return station_counts_[static_cast<size_t>(station)];
+    }
+
+    size_t count_in(LotStatusKind status) const
+    {
+        return status_counts_[static_cast<size_t>(status)];
+    }
+
+    // Prints the number of lots at each station and in each status
+    void print_summary(std::ostream& out) const
+    {
+        static const char *station_names[STATION_COUNT] = {
+            "invalid", "cocoa butter", "sugar", "milk", "vanilla", "tempering"
+        };
+        static const char *status_names[LOT_STATUS_COUNT] = {
+            "waiting", "processing", "completed"
+        };
+
+        out << lots_.size() << " lots:";
+        for (size_t i = 1; i < STATION_COUNT; i++) {
+            out << " " << station_names[i] << " " << station_counts_[i] << ",";
+        }
+        for (size_t i = 0; i < LOT_STATUS_COUNT; i++) {
+            out << " " << status_names[i] << " " << status_counts_[i]
+                << (i + 1 < LOT_STATUS_COUNT ? "," : "");
+        }
+        out << std::endl;
+    }
+
+private:
+    void count(const Lot& lot)
+    {
+        station_counts_[static_cast<size_t>(lot.station)]++;
+        status_counts_[static_cast<size_t>(lot.lot_status)]++;
+    }
+
+    void uncount(const Lot& lot)
+    {
+        station_counts_[static_cast<size_t>(lot.station)]--;
+        status_counts_[static_cast<size_t>(lot.lot_status)]--;
+    }
+
+    std::unordered_map<uint32_t, Lot> lots_;
+    size_t station_counts_[STATION_COUNT];
+    size_t status_counts_[LOT_STATUS_COUNT];
+};
+
+}  // namespace application
+
+#endif  // LOT_STATE_CACHE_HPP